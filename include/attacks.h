@@ -0,0 +1,94 @@
+#ifndef _ATTACKS_H
+#define _ATTACKS_H
+#include "bitboard.h"
+
+/*
+    Sliding piece attacks are looked up from tables indexed by the occupied squares on the
+    pieces lines. Build with -DUSE_PEXT (make PEXT=1) on cpus with BMI2 to index with the
+    pext instruction, otherwise the index comes from a magic multiply.
+*/
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#endif
+
+typedef struct
+{
+        Bitboard mask; /* squares whose occupancy changes the attacks, edges excluded */
+        Bitboard magic;
+        Bitboard *attacks;
+        int shift;
+} SliderMagic;
+
+extern SliderMagic BISHOP_MAGICS[CHESS_BOARD_LEN];
+extern SliderMagic ROOK_MAGICS[CHESS_BOARD_LEN];
+
+extern Bitboard KNIGHT_ATTACKS[CHESS_BOARD_LEN];
+extern Bitboard KING_ATTACKS[CHESS_BOARD_LEN];
+/* [ChessColor][square], squares a pawn of that color attacks */
+extern Bitboard PAWN_ATTACKS[2][CHESS_BOARD_LEN];
+
+/* squares strictly between two squares on the same line, 0 if they are not on one */
+extern Bitboard BETWEEN_BB[CHESS_BOARD_LEN][CHESS_BOARD_LEN];
+/* the whole line through two squares (edge to edge), 0 if they are not on one */
+extern Bitboard LINE_BB[CHESS_BOARD_LEN][CHESS_BOARD_LEN];
+
+/* builds the tables, must be called once before any lookups. Safe to call again. */
+void chess_attacks_init(void);
+
+static inline unsigned int slider_magic_index(const SliderMagic *m, Bitboard occupied)
+{
+#if defined(USE_PEXT)
+        return (unsigned int)_pext_u64(occupied, m->mask);
+#else
+        return (unsigned int)(((occupied & m->mask) * m->magic) >> m->shift);
+#endif
+}
+
+static inline Bitboard bishop_attacks(int sq, Bitboard occupied)
+{
+        const SliderMagic *m = &BISHOP_MAGICS[sq];
+        return m->attacks[slider_magic_index(m, occupied)];
+}
+
+static inline Bitboard rook_attacks(int sq, Bitboard occupied)
+{
+        const SliderMagic *m = &ROOK_MAGICS[sq];
+        return m->attacks[slider_magic_index(m, occupied)];
+}
+
+static inline Bitboard queen_attacks(int sq, Bitboard occupied)
+{
+        return bishop_attacks(sq, occupied) | rook_attacks(sq, occupied);
+}
+
+/* attacks of any piece type, pawns use their capture squares */
+Bitboard piece_attacks(ChessPieceType type, ChessColor color, int sq, Bitboard occupied);
+
+/* pieces of both colors that attack sq if only the occupied squares were filled */
+static inline Bitboard chess_position_attackers_to(ChessPosition *pos, int sq, Bitboard occupied)
+{
+        Bitboard bishops = pos->pieces[WHITE][BISHOP] | pos->pieces[BLACK][BISHOP] |
+                           pos->pieces[WHITE][QUEEN] | pos->pieces[BLACK][QUEEN];
+        Bitboard rooks = pos->pieces[WHITE][ROOK] | pos->pieces[BLACK][ROOK] |
+                         pos->pieces[WHITE][QUEEN] | pos->pieces[BLACK][QUEEN];
+        return (PAWN_ATTACKS[BLACK][sq] & pos->pieces[WHITE][PAWN]) |
+               (PAWN_ATTACKS[WHITE][sq] & pos->pieces[BLACK][PAWN]) |
+               (KNIGHT_ATTACKS[sq] & (pos->pieces[WHITE][KNIGHT] | pos->pieces[BLACK][KNIGHT])) |
+               (KING_ATTACKS[sq] & (pos->pieces[WHITE][KING] | pos->pieces[BLACK][KING])) |
+               (bishop_attacks(sq, occupied) & bishops) |
+               (rook_attacks(sq, occupied) & rooks);
+}
+
+/* returns 1 if any piece of color by attacks sq, checked outward from sq */
+static inline int chess_position_is_square_attacked(ChessPosition *pos, int sq, ChessColor by)
+{
+        /* a pawn of the other color on sq would attack the pawns that attack sq */
+        Bitboard queens = pos->pieces[by][QUEEN];
+        return (PAWN_ATTACKS[!by][sq] & pos->pieces[by][PAWN]) ||
+               (KNIGHT_ATTACKS[sq] & pos->pieces[by][KNIGHT]) ||
+               (KING_ATTACKS[sq] & pos->pieces[by][KING]) ||
+               (bishop_attacks(sq, pos->all) & (pos->pieces[by][BISHOP] | queens)) ||
+               (rook_attacks(sq, pos->all) & (pos->pieces[by][ROOK] | queens));
+}
+
+#endif
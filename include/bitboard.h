@@ -0,0 +1,145 @@
+#ifndef _BITBOARD_H
+#define _BITBOARD_H
+#include <stdint.h>
+#include "chess.h"
+
+/* one bit per square */
+typedef uint64_t Bitboard;
+
+/*
+    Squares are numbered 0-63, a1 = 0, b1 = 1 ... h8 = 63.
+    x is the file and y the rank, the same as indexing a ChessBoard with [x][y].
+*/
+#define SQUARE(x, y) ((y) * CHESS_BOARD_WIDTH + (x))
+#define SQUARE_FILE(sq) ((sq) & (CHESS_BOARD_WIDTH - 1))
+#define SQUARE_RANK(sq) ((sq) / CHESS_BOARD_WIDTH)
+#define NO_SQUARE CHESS_BOARD_LEN
+
+#define BB_SQUARE(sq) (((Bitboard)1) << (sq))
+#define BB_FILE_A 0x0101010101010101ULL
+#define BB_FILE_H (BB_FILE_A << 7)
+#define BB_RANK_1 0xFFULL
+#define BB_RANK_8 (BB_RANK_1 << 56)
+#define BB_FILE(x) (BB_FILE_A << (x))
+#define BB_RANK(y) (BB_RANK_1 << (8 * (y)))
+
+/* castling rights */
+#define CASTLE_WHITE_KING 1
+#define CASTLE_WHITE_QUEEN 2
+#define CASTLE_BLACK_KING 4
+#define CASTLE_BLACK_QUEEN 8
+#define CASTLE_ALL 15
+
+typedef struct
+{
+        /* [ChessColor][ChessPieceType], the NONE entry is unused */
+        Bitboard pieces[2][KING + 1];
+        Bitboard occupied[2];
+        Bitboard all;
+        /* ChessPiece on each square (type and color bits only), 0 when empty */
+        ChessPiece squares[CHESS_BOARD_LEN];
+        ChessColor turn_color;
+        int castling;
+        /* square a pawn can take en passant, NO_SQUARE if no enemy pawn can */
+        int en_passant;
+        /* half moves since the last capture or pawn move */
+        int fifty_move_rule_turn_count;
+        int num_turns;
+        /* zobrist key of everything above, updated on each move */
+        uint64_t key;
+        /* zobrist key of the pawns alone, for the pawn table */
+        uint64_t pawn_key;
+        /* material and piece-square values of white less black's, see eval.h, updated on each move */
+        int eval_mg, eval_eg;
+        /* EVAL_PHASE of the pieces on the board */
+        int phase;
+} ChessPosition;
+
+static inline int bb_popcount(Bitboard b)
+{
+#if defined(__GNUC__)
+        return __builtin_popcountll(b);
+#else
+        int n = 0;
+        while (b)
+        {
+                b &= b - 1;
+                n++;
+        }
+        return n;
+#endif
+}
+
+/* index of the lowest set bit, b must not be 0 */
+static inline int bb_lsb(Bitboard b)
+{
+#if defined(__GNUC__)
+        return __builtin_ctzll(b);
+#else
+        int n = 0;
+        while (!(b & 1))
+        {
+                b >>= 1;
+                n++;
+        }
+        return n;
+#endif
+}
+
+/* removes the lowest set bit from *b and returns its index */
+static inline int bb_pop_lsb(Bitboard *b)
+{
+        int sq = bb_lsb(*b);
+        *b &= *b - 1;
+        return sq;
+}
+
+/* everything make_move changes that unmake_move cannot work out from the move */
+typedef struct
+{
+        ChessMove move;
+        ChessPiece captured;
+        int castling;
+        int en_passant;
+        int fifty_move_rule_turn_count;
+        uint64_t key;
+} ChessUndo;
+
+#define POS_TYPE_AT(pos, sq) CP_GET_TYPE((pos)->squares[sq])
+#define POS_COLOR_AT(pos, sq) CP_GET_COLOR((pos)->squares[sq])
+
+void chess_position_clear(ChessPosition *pos);
+
+void chess_position_put_piece(ChessPosition *pos, int sq, ChessPieceType type, ChessColor color);
+
+void chess_position_remove_piece(ChessPosition *pos, int sq);
+
+/* castling rights come from the has moved bits of the kings and rooks,
+    en passant from an enemy pawn that has just moved two squares.
+    Needs chess_attacks_init and chess_zobrist_init to have been called.
+*/
+void chess_position_from_game(ChessPosition *pos, ChessGame *game);
+
+/* writes the position back so the board can be printed and serialized */
+void chess_position_to_game(ChessPosition *pos, ChessGame *game);
+
+/* only writes the board, the has moved bits follow the castling rights and en passant square */
+void chess_position_to_board(ChessPosition *pos, ChessBoard board);
+
+/* plays a move from chess_position_generate_moves and records what it needs to be taken back in undo */
+void chess_position_make_move(ChessPosition *pos, ChessMove move, ChessUndo *undo);
+
+/* takes back the last move made with undo */
+void chess_position_unmake_move(ChessPosition *pos, ChessUndo *undo);
+
+/* 1 if the side to move has a pawn that can take on ep, and ep is empty with the enemy pawn in front of it */
+int chess_position_can_take_en_passant(ChessPosition *pos, int ep);
+
+/* drops the castling rights whose king or rook is not on its starting square */
+void chess_position_trim_castling(ChessPosition *pos);
+
+int chess_position_find_king(ChessPosition *pos, ChessColor c);
+
+void chess_position_print(ChessPosition *pos);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef _BOOK_H
+#define _BOOK_H
+#include <stddef.h>
+#include "bitboard.h"
+
+/* the Polyglot Random64 keys: 768 for the pieces, 4 castling rights, 8 en passant files and the side to move */
+#define POLYGLOT_KEYS_LEN 781
+/* most moves kept for one position */
+#define POLYGLOT_MAX_MOVES 64
+
+/*
+    A Polyglot .bin book is 16 byte big endian entries sorted by key: key, move, weight and learn.
+    The file is mapped and searched in place, nothing is read into memory.
+*/
+typedef struct PolyglotBook
+{
+        const unsigned char *map;
+        size_t map_len;
+        size_t len;
+#ifdef _WIN32
+        void *file, *mapping;
+#endif
+} PolyglotBook;
+
+/* the Polyglot key of pos, the same for any book */
+uint64_t chess_position_polyglot_key(ChessPosition *pos);
+
+/* returns 0, or -1 after printing why the file can't be used */
+int polyglot_book_open(PolyglotBook *book, const char *filename);
+
+void polyglot_book_close(PolyglotBook *book);
+
+/* the legal book moves of pos and their weights, returns how many. Entries the book has with weight 0 are left out */
+int polyglot_book_moves(PolyglotBook *book, ChessPosition *pos, ChessMove *moves, int *weights);
+
+/* one of the book moves of pos chosen at random in proportion to their weights, random is any random number.
+    Returns MOVE_NONE when pos is not in the book.
+*/
+ChessMove polyglot_book_pick(PolyglotBook *book, ChessPosition *pos, uint64_t random);
+
+#endif
@@ -77,11 +77,19 @@ typedef struct
         ChessBoardData data;
 } ChessGame;
 
-/* you can pass NULL if you dont have any data */
-void chess_game_start(ChessGame *start_data, int enable_ai, ChessColor ai_color);
+struct PolyglotBook;
 
+/* you can pass NULL if you dont have any data.
+    book is a Polyglot book the AI plays from while the game is in it, or NULL, see book.h
+*/
+void chess_game_start(ChessGame *start_data, int enable_ai, ChessColor ai_color, struct PolyglotBook *book);
+
+/* writes a CHESS_PACK_MAGIC header and one packed record, see pack.h */
 void chess_game_serialize(ChessGame* game, char* filename);
 
+/* reads a file from chess_game_serialize, or a raw struct dump from before the packed format.
+    ret_game is unchanged if the file can't be read.
+*/
 void chess_game_deserialize(ChessGame* ret_game, char* filename);
 
 void chess_board_init(ChessBoard b);
@@ -92,18 +100,16 @@ void chess_board_print(ChessBoard b);
 
 void generate_moves(ChessBoard b, int x, int y, Move *return_moves, int *return_len);
 
-const char *generate_move_label(ChessBoard board, LegalMove lm, int force_include_origin_rank, int force_include_origin_file);
-
 int char_to_file(char c);
 
 char type_to_char(ChessPieceType t);
 
 void chess_board_populate(ChessBoard b, unsigned int i, unsigned int j);
 
-/* Generate all legal moves for this turn */
-LegalMoveArray *generate_legal_moves(ChessGame* game, ChessColor turn_color);
+/* Generate all legal moves for this turn into ret */
+void generate_legal_moves(ChessGame* game, ChessColor turn_color, MoveList *ret);
 
-void chess_board_move_piece(ChessBoard board, LegalMove move);
+void chess_board_move_piece(ChessBoard board, ChessMove move);
 
 /*  Getter and Setter for ChessPiece Type */
 #define CP_GET_TYPE(piece) ((piece) & ((1 << CHESS_PIECE_TYPE_BIT_LEN) - 1))
@@ -174,10 +180,9 @@ void chess_board_move_piece(ChessBoard board, LegalMove move);
         } while (0)
 
 
-void add_castle_move(ChessGame *game, LegalMoveArray *lma);
-
-void remove_illegal_moves_while_in_check(ChessGame *game, LegalMoveArray *lma);
-
 int chess_game_is_king_in_check(ChessGame *game, ChessColor c);
 
+/* plays a legal move for the player to move, doesn't change the turn color */
+void chess_game_play_move(ChessGame *game, ChessMove move);
+
 #endif
\ No newline at end of file
@@ -25,4 +25,10 @@ void free_str_array(StrArray str_array);
 /* gets from stdin*/
 char *input(char final_char, size_t *ret_len);
 
+/* wall clock time in seconds, only useful for measuring intervals */
+double get_time(void);
+
+/* number of cores that can run threads, at least 1 */
+int get_cpu_count(void);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef _EVAL_H
+#define _EVAL_H
+#include "bitboard.h"
+#include "pawns.h"
+
+/* centipawns for each ChessPieceType, NONE and KING are 0 */
+extern const int PIECE_VALUES[KING + 1];
+
+/* material in the middlegame and the endgame, the evaluation blends the two by phase */
+extern const int EVAL_MATERIAL_MG[KING + 1];
+extern const int EVAL_MATERIAL_EG[KING + 1];
+
+/* how much each piece counts towards the middlegame, the start position adds up to EVAL_PHASE_MAX */
+extern const int EVAL_PHASE[KING + 1];
+#define EVAL_PHASE_MAX 24
+
+/* piece-square tables for white, written rank 8 first the way the board is printed */
+extern const short EVAL_PST_MG[KING + 1][CHESS_BOARD_LEN];
+extern const short EVAL_PST_EG[KING + 1][CHESS_BOARD_LEN];
+
+/* index in the piece-square tables of a piece of color on sq, black uses them mirrored */
+#define EVAL_PST_SQUARE(sq, color) ((color) == WHITE ? (sq) ^ 56 : (sq))
+
+/* adds (sign 1) or takes away (sign -1) a piece from the eval terms of pos, called as pieces are put and removed */
+static inline void chess_position_eval_piece(ChessPosition *pos, int sq, ChessPieceType type, ChessColor color, int sign)
+{
+        int i = EVAL_PST_SQUARE(sq, color);
+        int s = color == WHITE ? sign : -sign;
+        pos->eval_mg += s * (EVAL_MATERIAL_MG[type] + EVAL_PST_MG[type][i]);
+        pos->eval_eg += s * (EVAL_MATERIAL_EG[type] + EVAL_PST_EG[type][i]);
+        pos->phase += sign * EVAL_PHASE[type];
+}
+
+/* a piece going from one square to another only changes its piece-square values */
+static inline void chess_position_eval_move(ChessPosition *pos, int from, int to, ChessPieceType type, ChessColor color)
+{
+        int f = EVAL_PST_SQUARE(from, color), t = EVAL_PST_SQUARE(to, color);
+        int s = color == WHITE ? 1 : -1;
+        pos->eval_mg += s * (EVAL_PST_MG[type][t] - EVAL_PST_MG[type][f]);
+        pos->eval_eg += s * (EVAL_PST_EG[type][t] - EVAL_PST_EG[type][f]);
+}
+
+/* score of pos in centipawns, positive is good for the side to move.
+    Material, piece-square values and pawn structure blended between middlegame and endgame by the phase.
+    The first two are the terms make and unmake keep up to date, so no square is scanned.
+    The pawn structure comes from pawns, each thread's own table, or is worked out again if it is NULL.
+*/
+int chess_position_evaluate(ChessPosition *pos, PawnTable *pawns);
+
+#endif
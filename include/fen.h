@@ -0,0 +1,26 @@
+#ifndef _FEN_H
+#define _FEN_H
+#include "bitboard.h"
+
+#define FEN_START "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+/* longest FEN chess_position_to_fen writes, with the terminating 0 */
+#define FEN_MAX_LEN 128
+
+/* Reads the FEN at the start of fen without copying or allocating, the clocks may be left out (EPD).
+    Castling rights without the king and rook on their squares are dropped, and the en passant
+    square is only kept when a pawn can take on it.
+    Returns the number of chars read, or -1 if fen is not a legal FEN, then pos is undefined.
+    That includes a king count other than one each, pawns on the first or last rank,
+    and the side not to move being in check.
+*/
+int chess_position_from_fen(ChessPosition *pos, const char *fen);
+
+/* writes the FEN of pos into buf, which needs FEN_MAX_LEN chars, returns its length */
+int chess_position_to_fen(ChessPosition *pos, char *buf);
+
+/* the has moved bits are set from the castling rights and en passant square */
+int chess_game_from_fen(ChessGame *game, const char *fen);
+
+int chess_game_to_fen(ChessGame *game, char *buf);
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef _MOVE_H
 #define _MOVE_H
 
+#include <stdint.h>
 #include "common.h"
 
 typedef struct
@@ -23,21 +24,53 @@ typedef struct
         int len;
 } MoveArray;
 
-typedef struct LegalMove
-{
-        Vec2 origin_sqaure;
-        Move move;
-        struct LegalMove* next;
-} LegalMove;
+/*
+    Total Bits: 16
+    0-5 - origin square (a1 = 0 ... h8 = 63)
+    6-11 - destination square
+    12-15 - flags
+*/
+typedef uint16_t ChessMove;
+
+#define MOVE_NONE 0
+
+/* flags, castling moves the rook and en passant takes the pawn behind the destination */
+#define MOVE_QUIET 0
+#define MOVE_DOUBLE_PAWN_PUSH 1
+#define MOVE_KING_CASTLE 2
+#define MOVE_QUEEN_CASTLE 3
+#define MOVE_CAPTURE 4
+#define MOVE_EN_PASSANT 5
+/* the low two bits of a promotion are the new piece type - BISHOP */
+#define MOVE_PROMOTION 8
+#define MOVE_PROMOTION_CAPTURE 12
 
+#define MOVE_ENCODE(from, to, flags) ((ChessMove)((from) | ((to) << 6) | ((flags) << 12)))
+#define MOVE_FROM(m) ((m) & 0x3F)
+#define MOVE_TO(m) (((m) >> 6) & 0x3F)
+#define MOVE_FLAGS(m) ((m) >> 12)
+#define MOVE_IS_CAPTURE(m) ((MOVE_FLAGS(m) & MOVE_CAPTURE) != 0)
+#define MOVE_IS_PROMOTION(m) ((MOVE_FLAGS(m) & MOVE_PROMOTION) != 0)
+#define MOVE_IS_CASTLE(m) (MOVE_FLAGS(m) == MOVE_KING_CASTLE || MOVE_FLAGS(m) == MOVE_QUEEN_CASTLE)
+/* ChessPieceType the pawn promotes to */
+#define MOVE_PROMOTION_TYPE(m) ((MOVE_FLAGS(m) & 3) + BISHOP)
+
+/* the most moves any position has is 218 */
+#define MOVE_LIST_CAPACITY 256
+
+/* fixed capacity, meant to live on the stack or in a per ply buffer */
 typedef struct
 {
-        LegalMove *arr;
+        ChessMove moves[MOVE_LIST_CAPACITY];
         int len;
-} LegalMoveArray;
+} MoveList;
+
+#define MOVE_LIST_ADD(list, m) ((list)->moves[(list)->len++] = (m))
 
-void legal_move_add_next(LegalMove* dest, LegalMove add);
+/* writes the move in coordinate notation (e2e4, e7e8q), buf needs 6 chars */
+void move_to_string(ChessMove m, char *buf);
 
-void free_legal_move_array(LegalMoveArray *lma);
+/* index of move in list, -1 if it is not there */
+int move_list_find(MoveList *list, ChessMove move);
 
-#endif
\ No newline at end of file
+#endif
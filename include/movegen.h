@@ -0,0 +1,25 @@
+#ifndef _MOVEGEN_H
+#define _MOVEGEN_H
+#include "bitboard.h"
+#include "move.h"
+
+/* Generate every pseudo legal move for the side to move into list, moves may leave the king in check.
+    Castling is only generated when the king does not start, pass or land on an attacked square.
+*/
+void chess_position_generate_moves(ChessPosition *pos, MoveList *list);
+
+/* returns 1 if the king of color c is attacked */
+int chess_position_in_check(ChessPosition *pos, ChessColor c);
+
+/* returns 1 if movegen and make/unmake can work on the position: one king per side,
+    no pawns on the first or last rank and the side that just moved is not in check.
+    Needs the pieces and turn_color set.
+*/
+int chess_position_is_valid(ChessPosition *pos);
+
+/* Generate only the moves that do not leave the king in check.
+    Checkers and pinned pieces are found once, so no move has to be played to test it.
+*/
+void chess_position_generate_legal_moves(ChessPosition *pos, MoveList *list);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef _PACK_H
+#define _PACK_H
+#include "bitboard.h"
+
+/*
+    Compact position record, every field is little endian so files can move between machines.
+    Bytes:
+    0-7 - occupancy, bit n set when square n has a piece
+    8-23 - one 4 bit code per occupied square from a1 up, low nibble first.
+           bits 0-2 ChessPieceType, bit 3 set for white
+    24 - bit 0 white to move, bits 1-4 castling rights, bit 5 white was checked, bit 6 black was checked
+    25 - en passant file + 1, 0 for none
+    26 - fifty move rule half moves
+    27 - moves the white king has been in check for
+    28 - moves the black king has been in check for
+    29 - 0
+    30-31 - ChessBoardData.num_turns
+    Counters that don't fit are saturated.
+*/
+#define CHESS_PACKED_LEN 32
+
+/* a file is a header followed by records */
+#define CHESS_PACK_MAGIC "CCPK"
+#define CHESS_PACK_VERSION 1
+/*
+    Bytes:
+    0-3 - CHESS_PACK_MAGIC
+    4-5 - CHESS_PACK_VERSION
+    6-7 - CHESS_PACKED_LEN
+*/
+#define CHESS_PACK_HEADER_LEN 8
+
+typedef struct
+{
+        unsigned char bytes[CHESS_PACKED_LEN];
+} ChessPackedPosition;
+
+void chess_game_pack(ChessGame *game, ChessPackedPosition *packed);
+
+/* returns 0, or -1 if packed is not a legal record, then game is unchanged */
+int chess_game_unpack(ChessGame *game, const ChessPackedPosition *packed);
+
+void chess_position_pack(ChessPosition *pos, ChessPackedPosition *packed);
+
+/* returns 0, or -1 if packed is not a legal record, then pos is undefined.
+    Records chess_position_is_valid turns down are not legal either.
+*/
+int chess_position_unpack(ChessPosition *pos, const ChessPackedPosition *packed);
+
+void chess_pack_write_header(unsigned char *header);
+
+/* returns 0 if header starts a file this version can read, otherwise prints why and returns -1 */
+int chess_pack_check_header(const unsigned char *header, const char *filename);
+
+#endif
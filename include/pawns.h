@@ -0,0 +1,66 @@
+#ifndef _PAWNS_H
+#define _PAWNS_H
+#include "bitboard.h"
+
+/* entries of a PawnTable, a power of 2. 128KB, small enough for each search thread to have its own */
+#define PAWN_TABLE_LEN 4096
+
+/* the pawn structure of both sides, it only depends on where the pawns are */
+typedef struct
+{
+        /* ChessPosition.pawn_key of the pawns this entry describes */
+        uint64_t key;
+        /* doubled, isolated, backward and passed pawns of white less black's */
+        int mg, eg;
+        /* [ChessColor] pawns with no enemy pawn in front of them or on the files beside them */
+        Bitboard passed[2];
+} PawnEntry;
+
+/* not shared between threads, so no locking and no check for half written entries */
+typedef struct
+{
+        PawnEntry entries[PAWN_TABLE_LEN];
+} PawnTable;
+
+/* a PawnTable for each search thread, kept by the caller between searches like the transposition table,
+    as the pawns barely change from one move to the next
+*/
+typedef struct
+{
+        PawnTable *tables;
+        int len;
+} PawnTables;
+
+/* bonus for a passed pawn by the rank it has reached, counted from its own side */
+extern const int PAWN_PASSED_MG[CHESS_BOARD_HEIGHT];
+extern const int PAWN_PASSED_EG[CHESS_BOARD_HEIGHT];
+
+/* empties the table, a table from calloc is already empty */
+void pawn_table_clear(PawnTable *table);
+
+/* starts with no tables, the searches add them */
+void pawn_tables_init(PawnTables *pawns);
+
+/* makes sure there are at least len tables, new ones are empty. Exits if it can't allocate them */
+void pawn_tables_reserve(PawnTables *pawns, int len);
+
+void pawn_tables_free(PawnTables *pawns);
+
+/* the pawn structure of pos, from the table when its pawns have been seen before.
+    Returns an entry of table, which the next probe may replace.
+*/
+PawnEntry *pawn_table_probe(PawnTable *table, ChessPosition *pos);
+
+/* works out the pawn structure of pos without a table */
+void chess_position_evaluate_pawns(ChessPosition *pos, PawnEntry *entry);
+
+/* the pawn terms of the evaluation, white less black's: the cached structure of entry, made for pos,
+    and what depends on the other pieces and can't be cached, the pawns in front of each king and
+    the passed pawns with a piece in their way.
+*/
+void pawn_entry_score(PawnEntry *entry, ChessPosition *pos, int *mg, int *eg);
+
+/* the pawn key of pos worked out from scratch, make_move keeps pos->pawn_key equal to this */
+uint64_t chess_position_compute_pawn_key(ChessPosition *pos);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef _PERFT_H
+#define _PERFT_H
+#include "chess.h"
+#include "bitboard.h"
+
+#define PERFT_MAX_DEPTH 16
+
+/* node count of a subtree, the key is stored xor'ed with data like TTEntry.
+    data bits 0-7 are the depth, the rest the count.
+*/
+typedef struct
+{
+        uint64_t key;
+        uint64_t data;
+} PerftEntry;
+
+/* shared by every perft thread without locks, a new count always replaces the old one */
+typedef struct
+{
+        PerftEntry *entries;
+        /* number of entries - 1, a power of two */
+        uint64_t mask;
+} PerftTable;
+
+typedef struct
+{
+        /* 0 for one per core, 1 counts on the calling thread */
+        int threads;
+        /* transposed subtrees are counted once, NULL to count every node */
+        PerftTable *table;
+} PerftOptions;
+
+typedef struct
+{
+        const char *name;
+        const char *fen;
+        int max_depth;
+        /* expected node counts, nodes[d - 1] is depth d */
+        unsigned long long nodes[PERFT_MAX_DEPTH];
+} PerftReference;
+
+/* counts the leaf nodes of the move tree to depth */
+unsigned long long chess_position_perft(ChessPosition *pos, int depth);
+
+/* splits the moves of the first two plies between the threads.
+    move_nodes can be NULL, otherwise it gets the count under each move in the order
+    chess_position_generate_legal_moves gives them.
+*/
+unsigned long long chess_position_perft_parallel(ChessPosition *pos, int depth, const PerftOptions *options,
+                                                 unsigned long long *move_nodes);
+
+unsigned long long chess_game_perft(ChessGame *game, int depth);
+
+/* prints the node count under each root move, returns the total */
+unsigned long long chess_game_perft_divide(ChessGame *game, int depth, const PerftOptions *options);
+
+/* runs every reference position up to max_depth (or its own limit),
+    returns the number of failed depths.
+*/
+int perft_run_reference_suite(int max_depth, const PerftOptions *options);
+
+/* allocates the largest power of two number of entries that fits in mb megabytes, exits if it can't */
+void perft_table_init(PerftTable *table, size_t mb);
+
+void perft_table_free(PerftTable *table);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef _PGN_H
+#define _PGN_H
+#include <stdio.h>
+#include "bitboard.h"
+
+/* the reader holds one chunk of the file at a time, so memory use doesn't grow with the file */
+#define PGN_CHUNK_LEN 65536
+/* longer tokens and tag values are cut short */
+#define PGN_TOKEN_LEN 256
+
+typedef struct
+{
+        FILE *f;
+        char chunk[PGN_CHUNK_LEN];
+        size_t chunk_len, chunk_pos;
+        /* file offset of the next char */
+        long offset;
+        /* a game starting at or after this offset is left for another reader, -1 for no limit */
+        long end;
+        /* one char put back, EOF if none */
+        int pushback;
+} PgnReader;
+
+typedef struct
+{
+        char white[PGN_TOKEN_LEN];
+        char black[PGN_TOKEN_LEN];
+        char result[PGN_TOKEN_LEN];
+        /* FEN tag, empty if the game starts from the usual position */
+        char fen[PGN_TOKEN_LEN];
+        /* the position after the moves played so far */
+        ChessPosition pos;
+        int plies;
+        /* first move that could not be played, the rest of the game is skipped. Empty if every move was played. */
+        char error[PGN_TOKEN_LEN];
+} PgnGame;
+
+/* called with each move before it is made on game->pos */
+typedef void (*PgnMoveFn)(PgnGame *game, ChessMove move, void *arg);
+
+/* reads the games that start in [start, end) of filename, end -1 for the end of the file.
+    A reader that doesn't start at 0 skips to the first "[Event " line, so a file can be split
+    at any offsets between threads and every game is read once. Returns 0, or -1 if the file can't be opened.
+*/
+int pgn_reader_open(PgnReader *reader, const char *filename, long start, long end);
+
+void pgn_reader_close(PgnReader *reader);
+
+/* reads the next game, replaying its moves with make_move. on_move can be NULL.
+    Returns 1 if a game was read, 0 when there are no more.
+*/
+int pgn_read_game(PgnReader *reader, PgnGame *game, PgnMoveFn on_move, void *arg);
+
+#endif
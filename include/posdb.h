@@ -0,0 +1,52 @@
+#ifndef _POSDB_H
+#define _POSDB_H
+#include <stddef.h>
+#include "pack.h"
+
+/*
+    A position database file is a pack.h header followed by ChessPackedPosition records,
+    the number of records is worked out from the file size.
+    Reading maps the whole file, so records are decoded straight from the page cache.
+*/
+typedef struct
+{
+        const unsigned char *map;
+        size_t map_len;
+        const ChessPackedPosition *records;
+        size_t len;
+#ifdef _WIN32
+        void *file, *mapping;
+#endif
+} PositionDatabase;
+
+typedef struct
+{
+        FILE *f;
+        size_t len;
+} PositionDatabaseWriter;
+
+/* called with each batch position_database_stream decodes */
+typedef void (*PositionBatchFn)(ChessPosition *batch, size_t len, void *arg);
+
+/* returns 0, or -1 after printing why the file can't be used */
+int position_database_open(PositionDatabase *db, const char *filename);
+
+void position_database_close(PositionDatabase *db);
+
+/* decodes records from *cursor on into batch until batch_len positions are filled or the records run out,
+    records that don't hold a legal position are skipped. Returns the number of positions filled, 0 at the end.
+*/
+size_t position_database_next_batch(PositionDatabase *db, size_t *cursor, ChessPosition *batch, size_t batch_len);
+
+/* decodes every record in batches of batch_len and passes them to fn, returns the number of positions */
+size_t position_database_stream(PositionDatabase *db, size_t batch_len, PositionBatchFn fn, void *arg);
+
+/* returns 0, or -1 if filename can't be written */
+int position_database_create(PositionDatabaseWriter *writer, const char *filename);
+
+void position_database_append(PositionDatabaseWriter *writer, ChessPosition *pos);
+
+/* returns 0, or -1 if any write failed */
+int position_database_finish(PositionDatabaseWriter *writer);
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef _SAN_H
+#define _SAN_H
+#include "bitboard.h"
+
+#define SAN_OK 0
+/* no move in the list fits the text */
+#define SAN_NO_MATCH -1
+/* more than one move fits, the text needs a file or rank to tell them apart */
+#define SAN_AMBIGUOUS -2
+
+/* longest SAN and its terminating 0, Qa1xb2+ or exd8=Q# */
+#define SAN_MAX_LEN 8
+
+/* the SAN of each move of a MoveList, labels[i] names moves[i] */
+typedef struct
+{
+        char labels[MOVE_LIST_CAPACITY][SAN_MAX_LEN];
+        int len;
+} SanList;
+
+/* Finds the move written in standard algebraic notation (Nbd7, exd6, e8=Q, O-O-O) among legal,
+    the moves of pos. Check marks and annotations (+ # ! ?) at the end are ignored.
+    Returns SAN_OK and sets *move, or one of the errors above.
+*/
+int chess_position_parse_san(ChessPosition *pos, MoveList *legal, const char *san, ChessMove *move);
+
+/* Writes move, one of legal (the moves of pos), as SAN with a + or # when it gives check or mate.
+    san needs room for SAN_MAX_LEN chars. pos is played on and restored. Returns the length written.
+*/
+int chess_position_move_to_san(ChessPosition *pos, MoveList *legal, ChessMove move, char *san);
+
+/* Writes the SAN of every move in legal into ret. The other pieces that reach the same square
+    are found in one pass over the list instead of by comparing the labels afterwards.
+*/
+void chess_position_moves_to_san(ChessPosition *pos, MoveList *legal, SanList *ret);
+
+/* slots of a MoveIndex, a power of 2 well above the keys it can hold */
+#define MOVE_INDEX_SLOTS 2048
+/* SAN, SAN without the origin file and rank, and coordinates for each move, plus 0-0 and 0-0-0 */
+#define MOVE_INDEX_MAX_KEYS (3 * MOVE_LIST_CAPACITY + 2)
+
+typedef struct
+{
+        char key[SAN_MAX_LEN];
+        /* index in the MoveList, SAN_AMBIGUOUS when the key names more than one move */
+        short move;
+} MoveIndexEntry;
+
+/* Open addressed table from the text of each legal move of a position to its index in the MoveList.
+    Each move is keyed by its SAN without check marks (Nbd7), its coordinates (b8d7, e7e8q),
+    and its SAN without the origin file or rank (Nd7), which is ambiguous when another piece of the same type
+    can move there as well.
+*/
+typedef struct
+{
+        MoveIndexEntry slots[MOVE_INDEX_SLOTS];
+        /* slots in use, so the next build only clears those */
+        short used[MOVE_INDEX_MAX_KEYS];
+        int used_len;
+} MoveIndex;
+
+/* must be called once before the first build */
+void move_index_init(MoveIndex *index);
+
+/* indexes legal, the moves of pos, whose SAN has been written to labels by chess_position_moves_to_san */
+void move_index_build(MoveIndex *index, ChessPosition *pos, MoveList *legal, SanList *labels);
+
+/* Returns the index in the MoveList of the move text names, or SAN_NO_MATCH or SAN_AMBIGUOUS.
+    Check marks and annotations (+ # ! ?) and white space at the end are ignored.
+*/
+int move_index_find(MoveIndex *index, const char *text);
+
+#endif
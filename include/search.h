@@ -0,0 +1,71 @@
+#ifndef _SEARCH_H
+#define _SEARCH_H
+#include "bitboard.h"
+#include "tt.h"
+#include "pawns.h"
+
+#define SEARCH_MAX_PLY 128
+#define SEARCH_INFINITE 32001
+#define SEARCH_MATE 32000
+/* scores past this are mates, SEARCH_MATE - |score| is the number of plies to mate */
+#define SEARCH_MATE_BOUND (SEARCH_MATE - SEARCH_MAX_PLY)
+/* positions the tablebases say are won score SEARCH_TB_WIN less the ply they are found at, below any mate */
+#define SEARCH_TB_WIN (SEARCH_MATE_BOUND - 1)
+#define SEARCH_TB_BOUND (SEARCH_TB_WIN - SEARCH_MAX_PLY)
+
+/* seconds the game loop gives the AI for each move */
+#define SEARCH_DEFAULT_MOVE_TIME 0.1
+
+struct SearchResult;
+
+/* called by the search each time it finishes a depth, with the result so far */
+typedef void (*SearchProgressFn)(const struct SearchResult *result, void *arg);
+
+/* the search stops at whichever limit it reaches first, 0 means no limit */
+typedef struct
+{
+        int max_depth;
+        /* seconds */
+        double move_time;
+        unsigned long long max_nodes;
+        /* threads sharing the transposition table, 0 for one per core.
+            1 searches without starting a thread and always plays the same move for the same limits.
+        */
+        int threads;
+        /* another thread sets *stop to end the search early, NULL if only the limits above stop it */
+        volatile int *stop;
+        /* NULL for none, arg is passed back to it */
+        SearchProgressFn on_depth;
+        void *arg;
+        /* the tablebases loaded by syzygy_init are only probed this many plies or more from the horizon, 0 probes everywhere */
+        int tb_probe_depth;
+} SearchLimits;
+
+typedef struct SearchResult
+{
+        /* MOVE_NONE when the side to move has no legal moves */
+        ChessMove best_move;
+        /* centipawns for the side to move */
+        int score;
+        /* last depth that was searched to the end */
+        int depth;
+        /* of every thread */
+        unsigned long long nodes;
+        /* positions found in the tablebases */
+        unsigned long long tb_hits;
+        /* seconds */
+        double time;
+} SearchResult;
+
+/* iterative deepening alpha-beta search for the side to move, pos is left as it was.
+    tt can be NULL, keeping the same table between moves of a game lets each search start from the last.
+    With more than one thread the extra threads search the same position and only help by filling tt,
+    the move comes from the first thread. Without a tt only one thread is used.
+    pawns gets a table for each thread and is kept between moves the same way,
+    when it is NULL the pawn structures are only cached for this search.
+    When the DTZ tables have pos, their move is played without searching.
+*/
+void chess_position_search(ChessPosition *pos, const SearchLimits *limits, TranspositionTable *tt, PawnTables *pawns,
+                           SearchResult *result);
+
+#endif
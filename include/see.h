@@ -0,0 +1,12 @@
+#ifndef _SEE_H
+#define _SEE_H
+#include "bitboard.h"
+
+/* Static exchange evaluation of move, a move of the side to move that lands on a square.
+    Both sides keep capturing on that square with their least valuable piece, and either may stop
+    when going on would lose material. Returns what the mover ends up winning in PIECE_VALUES,
+    negative when the move loses material. Pins are not looked at, pieces behind others on a line join in.
+*/
+int chess_position_see(ChessPosition *pos, ChessMove move);
+
+#endif
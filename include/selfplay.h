@@ -0,0 +1,78 @@
+#ifndef _SELFPLAY_H
+#define _SELFPLAY_H
+#include <stdio.h>
+#include "search.h"
+#include "book.h"
+
+/* plies a game may last before it is adjudicated a draw */
+#define SELFPLAY_DEFAULT_MAX_PLIES 400
+
+/* how a game ended, indexes SELFPLAY_ENDING_NAMES */
+typedef enum
+{
+        SELFPLAY_CHECKMATE,
+        SELFPLAY_STALEMATE,
+        SELFPLAY_FIFTY_MOVES,
+        SELFPLAY_REPETITION,
+        SELFPLAY_INSUFFICIENT_MATERIAL,
+        /* adjudicated with the result the tablebases loaded by syzygy_init give */
+        SELFPLAY_TABLEBASE,
+        SELFPLAY_MAX_PLIES,
+        SELFPLAY_ENDINGS
+} SelfPlayEnding;
+
+extern const char *SELFPLAY_ENDING_NAMES[SELFPLAY_ENDINGS];
+
+/* indexes SelfPlaySummary.results */
+typedef enum
+{
+        SELFPLAY_WHITE_WINS,
+        SELFPLAY_BLACK_WINS,
+        SELFPLAY_DRAW,
+        SELFPLAY_RESULTS
+} SelfPlayResult;
+
+typedef struct
+{
+        int games;
+        /* games played at once, 0 for one per core. Each search inside a game uses limits.threads */
+        int threads;
+        /* for every move of both sides, the searches also use the tablebases if syzygy_init found any */
+        SearchLimits limits;
+        /* transposition table of each game thread, cleared between games */
+        size_t table_mb;
+        /* game i starts from openings[i % openings_len], NULL for the start position */
+        ChessPosition *openings;
+        int openings_len;
+        /* book moves are played from the opening while the game is in book, NULL for none.
+            The games are only read from it, all of the threads share it
+        */
+        PolyglotBook *book;
+        /* random legal moves played from the opening, or from where the book runs out, before the engines take over, so games differ */
+        int random_plies;
+        int max_plies;
+        /* random plies of game i are drawn from seed and i, so a run can be repeated */
+        unsigned long long seed;
+} SelfPlayOptions;
+
+typedef struct
+{
+        int games;
+        unsigned long long plies;
+        int results[SELFPLAY_RESULTS];
+        int endings[SELFPLAY_ENDINGS];
+        /* seconds */
+        double time;
+} SelfPlaySummary;
+
+/* Plays options->games games of the engine against itself on a pool of threads.
+    Each game is written to out as PGN as soon as it ends, in the order they end.
+*/
+void selfplay_run(const SelfPlayOptions *options, FILE *out, SelfPlaySummary *summary);
+
+/* reads one FEN or EPD per line into a malloced *openings, blank lines and # comments are skipped.
+    Returns the number read, or -1 if the file can't be read or a line is not a legal position.
+*/
+int selfplay_load_openings(const char *filename, ChessPosition **openings);
+
+#endif
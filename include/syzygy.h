@@ -0,0 +1,48 @@
+#ifndef _SYZYGY_H
+#define _SYZYGY_H
+#include "bitboard.h"
+
+/* the most pieces, kings included, of the tables that are looked for */
+#define SYZYGY_MAX_PIECES 6
+
+/* for the side to move. A cursed win is won but drawn by the fifty move rule, a blessed loss is the other side of one */
+typedef enum
+{
+        SYZYGY_LOSS = -2,
+        SYZYGY_BLESSED_LOSS = -1,
+        SYZYGY_DRAW = 0,
+        SYZYGY_CURSED_WIN = 1,
+        SYZYGY_WIN = 2
+} SyzygyWdl;
+
+/* maps the Syzygy WDL (.rtbw) and DTZ (.rtbz) files of up to SYZYGY_MAX_PIECES pieces found in path,
+    a list of directories separated by ':' (';' on Windows). The tables already loaded are let go first,
+    so NULL or "" only lets them go. Returns the most pieces of any WDL table found, 0 if there are none.
+    Call it before searching, the probes read the tables from every thread without locks.
+*/
+int syzygy_init(const char *path);
+
+void syzygy_free(void);
+
+/* the most pieces of any table loaded, 0 if none is */
+int syzygy_max_pieces(void);
+
+/* win, draw or loss for the side to move. *success is 0 when there is no table for pos,
+    it has castling rights, or a table is not a Syzygy file.
+    The tables are for positions without en passant, the captures of pos are played to account for it.
+*/
+SyzygyWdl chess_position_probe_wdl(ChessPosition *pos, int *success);
+
+/* plies to the next capture or pawn move with best play, positive when the side to move wins and negative when it loses.
+    100 is added to the distance of cursed wins and blessed losses, 0 is a draw and -1 is being mated.
+    Ignores the plies pos has been played without one, *success is set as for chess_position_probe_wdl.
+*/
+int chess_position_probe_dtz(ChessPosition *pos, int *success);
+
+/* the move the DTZ tables say is best: the quickest win that the fifty move rule does not draw,
+    a draw, or the longest loss. Returns MOVE_NONE when the tables can't rank every move, otherwise sets *wdl to
+    the result of the move after the plies already played towards the fifty move rule.
+*/
+ChessMove chess_position_probe_root(ChessPosition *pos, SyzygyWdl *wdl);
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef _TT_H
+#define _TT_H
+#include <stddef.h>
+#include <stdint.h>
+#include "move.h"
+
+/* what the stored score says about the real score */
+#define TT_BOUND_NONE 0
+/* the real score is at least the stored score, the search failed high */
+#define TT_BOUND_LOWER 1
+/* the real score is at most the stored score, no move raised alpha */
+#define TT_BOUND_UPPER 2
+#define TT_BOUND_EXACT 3
+
+#define TT_DEFAULT_MB 16
+/* entries that share a cache line, a new entry replaces the least useful of them */
+#define TT_BUCKET_LEN 4
+
+/*
+    16 bytes. data bits:
+    0-15 - best move
+    16-31 - score
+    32-39 - depth
+    40-41 - bound
+    42-47 - age
+    key is stored xor'ed with data, so an entry half written by another thread does not match any key.
+*/
+typedef struct
+{
+        uint64_t key;
+        uint64_t data;
+} TTEntry;
+
+typedef struct
+{
+        TTEntry entries[TT_BUCKET_LEN];
+} TTBucket;
+
+typedef struct
+{
+        ChessMove move;
+        int score;
+        int depth;
+        int bound;
+} TTData;
+
+/* shared by every thread searching the same game, no locks are taken */
+typedef struct
+{
+        TTBucket *buckets;
+        /* number of buckets - 1, the number is a power of two */
+        uint64_t mask;
+        /* bumped for each new search so old entries are replaced first */
+        unsigned age;
+        void *allocation;
+} TranspositionTable;
+
+/* allocates the largest power of two number of buckets that fits in mb megabytes, exits if it can't */
+void transposition_table_init(TranspositionTable *tt, size_t mb);
+
+void transposition_table_free(TranspositionTable *tt);
+
+void transposition_table_clear(TranspositionTable *tt);
+
+/* call once before each search */
+void transposition_table_new_search(TranspositionTable *tt);
+
+/* returns 1 and fills data if key has an entry */
+int transposition_table_probe(TranspositionTable *tt, uint64_t key, TTData *data);
+
+void transposition_table_store(TranspositionTable *tt, uint64_t key, ChessMove move, int score, int depth, int bound);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef _ZOBRIST_H
+#define _ZOBRIST_H
+#include "bitboard.h"
+
+/* random keys xor'ed together to identify a position, the key is kept in ChessPosition.key */
+extern uint64_t ZOBRIST_PIECES[2][KING + 1][CHESS_BOARD_LEN];
+/* indexed by the castling rights, the entry for no rights is 0 */
+extern uint64_t ZOBRIST_CASTLING[CASTLE_ALL + 1];
+/* indexed by the file of the en passant square */
+extern uint64_t ZOBRIST_EN_PASSANT[CHESS_BOARD_WIDTH];
+/* xor'ed in when black is to move */
+extern uint64_t ZOBRIST_TURN;
+
+/* fills the keys, must be called once before any position is built. Safe to call again. */
+void chess_zobrist_init(void);
+
+/* the key of pos worked out from scratch, make_move keeps pos->key equal to this */
+uint64_t chess_position_compute_key(ChessPosition *pos);
+
+/* key of the position the game is in, ignores the threat bits */
+uint64_t chess_game_hash(ChessGame *game);
+
+#endif
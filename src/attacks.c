@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include "../include/attacks.h"
+
+SliderMagic BISHOP_MAGICS[CHESS_BOARD_LEN];
+SliderMagic ROOK_MAGICS[CHESS_BOARD_LEN];
+
+Bitboard KNIGHT_ATTACKS[CHESS_BOARD_LEN];
+Bitboard KING_ATTACKS[CHESS_BOARD_LEN];
+Bitboard PAWN_ATTACKS[2][CHESS_BOARD_LEN];
+Bitboard BETWEEN_BB[CHESS_BOARD_LEN][CHESS_BOARD_LEN];
+Bitboard LINE_BB[CHESS_BOARD_LEN][CHESS_BOARD_LEN];
+
+/* sum of 2^(relevant bits) over every square */
+#define BISHOP_TABLE_LEN 5248
+#define ROOK_TABLE_LEN 102400
+
+static Bitboard BISHOP_TABLE[BISHOP_TABLE_LEN];
+static Bitboard ROOK_TABLE[ROOK_TABLE_LEN];
+
+static const Vec2 BISHOP_DIRECTIONS[] = {{1, 1}, {-1, 1}, {1, -1}, {-1, -1}};
+static const Vec2 ROOK_DIRECTIONS[] = {{0, 1}, {1, 0}, {0, -1}, {-1, 0}};
+static const Vec2 KNIGHT_JUMPS[] = {{2, 1}, {1, 2}, {-1, 2}, {-2, 1}, {-2, -1}, {-1, -2}, {1, -2}, {2, -1}};
+static const Vec2 KING_STEPS[] = {{0, 1}, {1, 1}, {1, 0}, {1, -1}, {0, -1}, {-1, -1}, {-1, 0}, {-1, 1}};
+
+static int on_board(int x, int y)
+{
+    return x >= 0 && x < CHESS_BOARD_WIDTH && y >= 0 && y < CHESS_BOARD_HEIGHT;
+}
+
+/* walks each direction until it leaves the board or hits an occupied square */
+static Bitboard slider_attacks_slow(int sq, Bitboard occupied, const Vec2 *dirs)
+{
+    Bitboard ret = 0;
+    int i;
+    for (i = 0; i < 4; i++)
+    {
+        int x = SQUARE_FILE(sq) + dirs[i].x, y = SQUARE_RANK(sq) + dirs[i].y;
+        while (on_board(x, y))
+        {
+            ret |= BB_SQUARE(SQUARE(x, y));
+            if (occupied & BB_SQUARE(SQUARE(x, y)))
+                break;
+            x += dirs[i].x;
+            y += dirs[i].y;
+        }
+    }
+    return ret;
+}
+
+static Bitboard step_attacks(int sq, const Vec2 *steps, int len)
+{
+    Bitboard ret = 0;
+    int i;
+    for (i = 0; i < len; i++)
+    {
+        int x = SQUARE_FILE(sq) + steps[i].x, y = SQUARE_RANK(sq) + steps[i].y;
+        if (on_board(x, y))
+            ret |= BB_SQUARE(SQUARE(x, y));
+    }
+    return ret;
+}
+
+#if !defined(USE_PEXT)
+/* xorshift64*, seeded the same every run so the magics are reproducible */
+static Bitboard magic_rand(Bitboard *state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+/* tries sparse random numbers until one maps every subset without a destructive collision */
+static void find_magic(SliderMagic *m, const Bitboard *occupancy, const Bitboard *reference, int size, Bitboard seed)
+{
+    static int epoch[4096], attempt = 0;
+    int i = 0;
+    while (i < size)
+    {
+        do
+        {
+            m->magic = magic_rand(&seed) & magic_rand(&seed) & magic_rand(&seed);
+        } while (bb_popcount((m->mask * m->magic) >> 56) < 6);
+        attempt++;
+        for (i = 0; i < size; i++)
+        {
+            unsigned int idx = slider_magic_index(m, occupancy[i]);
+            if (epoch[idx] < attempt)
+            {
+                epoch[idx] = attempt;
+                m->attacks[idx] = reference[i];
+            }
+            else if (m->attacks[idx] != reference[i])
+            {
+                break;
+            }
+        }
+    }
+}
+#endif
+
+static void init_slider(SliderMagic *magics, Bitboard *table, const Vec2 *dirs)
+{
+    static Bitboard occupancy[4096], reference[4096];
+    /* per rank seeds that find magics quickly */
+    static const Bitboard seeds[CHESS_BOARD_HEIGHT] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+    int sq;
+    Bitboard *next = table;
+    for (sq = 0; sq < CHESS_BOARD_LEN; sq++)
+    {
+        SliderMagic *m = &magics[sq];
+        /* edges only matter if the piece stands on them */
+        Bitboard edges = ((BB_RANK_1 | BB_RANK_8) & ~BB_RANK(SQUARE_RANK(sq))) |
+                         ((BB_FILE_A | BB_FILE_H) & ~BB_FILE(SQUARE_FILE(sq)));
+        m->mask = slider_attacks_slow(sq, 0, dirs) & ~edges;
+        m->shift = 64 - bb_popcount(m->mask);
+        m->attacks = next;
+
+        /* enumerate every subset of the mask (carry rippler) */
+        int size = 0;
+        Bitboard b = 0;
+        do
+        {
+            occupancy[size] = b;
+            reference[size++] = slider_attacks_slow(sq, b, dirs);
+            b = (b - m->mask) & m->mask;
+        } while (b);
+        next += size;
+
+#if defined(USE_PEXT)
+        int i;
+        (void)seeds;
+        m->magic = 0;
+        for (i = 0; i < size; i++)
+            m->attacks[_pext_u64(occupancy[i], m->mask)] = reference[i];
+#else
+        find_magic(m, occupancy, reference, size, seeds[SQUARE_RANK(sq)]);
+#endif
+    }
+}
+
+void chess_attacks_init(void)
+{
+    static int initialized = 0;
+    int sq;
+    if (initialized)
+        return;
+    initialized = 1;
+    for (sq = 0; sq < CHESS_BOARD_LEN; sq++)
+    {
+        int x = SQUARE_FILE(sq), y = SQUARE_RANK(sq);
+        KNIGHT_ATTACKS[sq] = step_attacks(sq, KNIGHT_JUMPS, 8);
+        KING_ATTACKS[sq] = step_attacks(sq, KING_STEPS, 8);
+        PAWN_ATTACKS[WHITE][sq] = 0;
+        PAWN_ATTACKS[BLACK][sq] = 0;
+        if (x > 0 && y < CHESS_BOARD_HEIGHT - 1)
+            PAWN_ATTACKS[WHITE][sq] |= BB_SQUARE(sq + 7);
+        if (x < CHESS_BOARD_WIDTH - 1 && y < CHESS_BOARD_HEIGHT - 1)
+            PAWN_ATTACKS[WHITE][sq] |= BB_SQUARE(sq + 9);
+        if (x > 0 && y > 0)
+            PAWN_ATTACKS[BLACK][sq] |= BB_SQUARE(sq - 9);
+        if (x < CHESS_BOARD_WIDTH - 1 && y > 0)
+            PAWN_ATTACKS[BLACK][sq] |= BB_SQUARE(sq - 7);
+    }
+    init_slider(BISHOP_MAGICS, BISHOP_TABLE, BISHOP_DIRECTIONS);
+    init_slider(ROOK_MAGICS, ROOK_TABLE, ROOK_DIRECTIONS);
+
+    int a, b;
+    for (a = 0; a < CHESS_BOARD_LEN; a++)
+    {
+        for (b = 0; b < CHESS_BOARD_LEN; b++)
+        {
+            BETWEEN_BB[a][b] = LINE_BB[a][b] = 0;
+            if (a == b)
+                continue;
+            if (bishop_attacks(a, 0) & BB_SQUARE(b))
+            {
+                LINE_BB[a][b] = (bishop_attacks(a, 0) & bishop_attacks(b, 0)) | BB_SQUARE(a) | BB_SQUARE(b);
+                BETWEEN_BB[a][b] = bishop_attacks(a, BB_SQUARE(b)) & bishop_attacks(b, BB_SQUARE(a));
+            }
+            else if (rook_attacks(a, 0) & BB_SQUARE(b))
+            {
+                LINE_BB[a][b] = (rook_attacks(a, 0) & rook_attacks(b, 0)) | BB_SQUARE(a) | BB_SQUARE(b);
+                BETWEEN_BB[a][b] = rook_attacks(a, BB_SQUARE(b)) & rook_attacks(b, BB_SQUARE(a));
+            }
+        }
+    }
+}
+
+Bitboard piece_attacks(ChessPieceType type, ChessColor color, int sq, Bitboard occupied)
+{
+    switch (type)
+    {
+    case PAWN:
+        return PAWN_ATTACKS[color][sq];
+    case BISHOP:
+        return bishop_attacks(sq, occupied);
+    case KNIGHT:
+        return KNIGHT_ATTACKS[sq];
+    case ROOK:
+        return rook_attacks(sq, occupied);
+    case QUEEN:
+        return queen_attacks(sq, occupied);
+    case KING:
+        return KING_ATTACKS[sq];
+    case NONE:
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,315 @@
+#include <string.h>
+#include "../include/bitboard.h"
+#include "../include/attacks.h"
+#include "../include/zobrist.h"
+#include "../include/eval.h"
+
+void chess_position_clear(ChessPosition *pos)
+{
+    memset(pos, 0, sizeof(ChessPosition));
+    pos->turn_color = WHITE;
+    pos->en_passant = NO_SQUARE;
+}
+
+void chess_position_put_piece(ChessPosition *pos, int sq, ChessPieceType type, ChessColor color)
+{
+    Bitboard bit = BB_SQUARE(sq);
+    ChessPiece piece = 0;
+    CP_SET_TYPE(piece, type);
+    CP_SET_COLOR(piece, color);
+    pos->squares[sq] = piece;
+    pos->key ^= ZOBRIST_PIECES[color][type][sq];
+    if (type == PAWN)
+        pos->pawn_key ^= ZOBRIST_PIECES[color][PAWN][sq];
+    chess_position_eval_piece(pos, sq, type, color, 1);
+    pos->pieces[color][type] |= bit;
+    pos->occupied[color] |= bit;
+    pos->all |= bit;
+}
+
+static void chess_position_move_piece(ChessPosition *pos, int from, int to)
+{
+    ChessPiece piece = pos->squares[from];
+    ChessColor color = CP_GET_COLOR(piece);
+    Bitboard bits = BB_SQUARE(from) | BB_SQUARE(to);
+    pos->pieces[color][CP_GET_TYPE(piece)] ^= bits;
+    pos->occupied[color] ^= bits;
+    pos->all ^= bits;
+    pos->squares[to] = piece;
+    pos->squares[from] = 0;
+    pos->key ^= ZOBRIST_PIECES[color][CP_GET_TYPE(piece)][from] ^ ZOBRIST_PIECES[color][CP_GET_TYPE(piece)][to];
+    if (CP_GET_TYPE(piece) == PAWN)
+        pos->pawn_key ^= ZOBRIST_PIECES[color][PAWN][from] ^ ZOBRIST_PIECES[color][PAWN][to];
+    chess_position_eval_move(pos, from, to, CP_GET_TYPE(piece), color);
+}
+
+void chess_position_remove_piece(ChessPosition *pos, int sq)
+{
+    ChessPiece piece = pos->squares[sq];
+    Bitboard bit = BB_SQUARE(sq);
+    if (CP_GET_TYPE(piece) == NONE)
+        return;
+    pos->pieces[CP_GET_COLOR(piece)][CP_GET_TYPE(piece)] &= ~bit;
+    pos->occupied[CP_GET_COLOR(piece)] &= ~bit;
+    pos->all &= ~bit;
+    pos->squares[sq] = 0;
+    pos->key ^= ZOBRIST_PIECES[CP_GET_COLOR(piece)][CP_GET_TYPE(piece)][sq];
+    if (CP_GET_TYPE(piece) == PAWN)
+        pos->pawn_key ^= ZOBRIST_PIECES[CP_GET_COLOR(piece)][PAWN][sq];
+    chess_position_eval_piece(pos, sq, CP_GET_TYPE(piece), CP_GET_COLOR(piece), -1);
+}
+
+/* returns 1 if the piece is there and has not moved */
+static int chess_board_is_unmoved(ChessBoard b, int x, int y, ChessPieceType t, ChessColor c)
+{
+    ChessSquare sq = b[x][y];
+    return CP_GET_TYPE(sq) == t && CP_GET_COLOR(sq) == c && CP_GET_HAS_MOVED(sq) == 0;
+}
+
+void chess_position_from_game(ChessPosition *pos, ChessGame *game)
+{
+    int x, y;
+    chess_position_clear(pos);
+    for (x = 0; x < CHESS_BOARD_WIDTH; x++)
+    {
+        for (y = 0; y < CHESS_BOARD_HEIGHT; y++)
+        {
+            ChessSquare sq = game->board[x][y];
+            if (CP_GET_TYPE(sq) == NONE)
+                continue;
+            chess_position_put_piece(pos, SQUARE(x, y), CP_GET_TYPE(sq), CP_GET_COLOR(sq));
+        }
+    }
+    pos->turn_color = game->data.turn_color;
+    pos->num_turns = game->data.num_turns;
+    pos->fifty_move_rule_turn_count = game->data.fifty_move_rule_turn_count;
+
+    if (chess_board_is_unmoved(game->board, 4, 0, KING, WHITE))
+    {
+        if (chess_board_is_unmoved(game->board, 7, 0, ROOK, WHITE))
+            pos->castling |= CASTLE_WHITE_KING;
+        if (chess_board_is_unmoved(game->board, 0, 0, ROOK, WHITE))
+            pos->castling |= CASTLE_WHITE_QUEEN;
+    }
+    if (chess_board_is_unmoved(game->board, 4, 7, KING, BLACK))
+    {
+        if (chess_board_is_unmoved(game->board, 7, 7, ROOK, BLACK))
+            pos->castling |= CASTLE_BLACK_KING;
+        if (chess_board_is_unmoved(game->board, 0, 7, ROOK, BLACK))
+            pos->castling |= CASTLE_BLACK_QUEEN;
+    }
+
+    /* an enemy pawn that has not been marked as moved off its home rank has just moved two squares */
+    ChessColor enemy = !game->data.turn_color;
+    int rank = enemy == WHITE ? 3 : 4, behind = enemy == WHITE ? 2 : 5;
+    for (x = 0; x < CHESS_BOARD_WIDTH; x++)
+    {
+        if (chess_board_is_unmoved(game->board, x, rank, PAWN, enemy) &&
+            CP_GET_TYPE(game->board[x][behind]) == NONE &&
+            (PAWN_ATTACKS[enemy][SQUARE(x, behind)] & pos->pieces[!enemy][PAWN]))
+        {
+            pos->en_passant = SQUARE(x, behind);
+            break;
+        }
+    }
+    pos->key = chess_position_compute_key(pos);
+}
+
+void chess_position_to_board(ChessPosition *pos, ChessBoard board)
+{
+    int x, y;
+    for (x = 0; x < CHESS_BOARD_WIDTH; x++)
+    {
+        for (y = 0; y < CHESS_BOARD_HEIGHT; y++)
+        {
+            int sq = SQUARE(x, y);
+            ChessPieceType type = POS_TYPE_AT(pos, sq);
+            ChessColor color = POS_COLOR_AT(pos, sq);
+            int has_moved = 0;
+            board[x][y] = 0;
+            CS_SET_COLOR(board[x][y], (x + y) % 2 ? WHITE : BLACK);
+            if (type == NONE)
+                continue;
+            CP_SET_TYPE(board[x][y], type);
+            CP_SET_COLOR(board[x][y], color);
+            switch (type)
+            {
+            case PAWN:
+                /* a pawn that just moved two squares stays unmoved so it can be taken en passant */
+                has_moved = y != (color == WHITE ? 1 : 6) &&
+                            !(pos->en_passant != NO_SQUARE && sq == pos->en_passant + (color == WHITE ? 8 : -8));
+                break;
+            case KING:
+                has_moved = !(pos->castling & (color == WHITE ? CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN
+                                                             : CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN));
+                break;
+            case ROOK:
+                if (sq == SQUARE(7, 0))
+                    has_moved = !(pos->castling & CASTLE_WHITE_KING);
+                else if (sq == SQUARE(0, 0))
+                    has_moved = !(pos->castling & CASTLE_WHITE_QUEEN);
+                else if (sq == SQUARE(7, 7))
+                    has_moved = !(pos->castling & CASTLE_BLACK_KING);
+                else if (sq == SQUARE(0, 7))
+                    has_moved = !(pos->castling & CASTLE_BLACK_QUEEN);
+                break;
+            default:
+                break;
+            }
+            CP_SET_HAS_MOVED(board[x][y], has_moved);
+        }
+    }
+}
+
+void chess_position_to_game(ChessPosition *pos, ChessGame *game)
+{
+    chess_position_to_board(pos, game->board);
+    game->data.turn_color = pos->turn_color;
+    game->data.num_turns = pos->num_turns;
+    game->data.fifty_move_rule_turn_count = pos->fifty_move_rule_turn_count;
+}
+
+int chess_position_can_take_en_passant(ChessPosition *pos, int ep)
+{
+    ChessColor us = pos->turn_color;
+    int pushed = us == WHITE ? ep - CHESS_BOARD_WIDTH : ep + CHESS_BOARD_WIDTH;
+    return !(pos->all & BB_SQUARE(ep)) && (pos->pieces[!us][PAWN] & BB_SQUARE(pushed)) &&
+           (PAWN_ATTACKS[!us][ep] & pos->pieces[us][PAWN]);
+}
+
+void chess_position_trim_castling(ChessPosition *pos)
+{
+    if (!(pos->pieces[WHITE][KING] & BB_SQUARE(SQUARE(4, 0))))
+        pos->castling &= ~(CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN);
+    if (!(pos->pieces[BLACK][KING] & BB_SQUARE(SQUARE(4, 7))))
+        pos->castling &= ~(CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN);
+    if (!(pos->pieces[WHITE][ROOK] & BB_SQUARE(SQUARE(7, 0))))
+        pos->castling &= ~CASTLE_WHITE_KING;
+    if (!(pos->pieces[WHITE][ROOK] & BB_SQUARE(SQUARE(0, 0))))
+        pos->castling &= ~CASTLE_WHITE_QUEEN;
+    if (!(pos->pieces[BLACK][ROOK] & BB_SQUARE(SQUARE(7, 7))))
+        pos->castling &= ~CASTLE_BLACK_KING;
+    if (!(pos->pieces[BLACK][ROOK] & BB_SQUARE(SQUARE(0, 7))))
+        pos->castling &= ~CASTLE_BLACK_QUEEN;
+}
+
+int chess_position_find_king(ChessPosition *pos, ChessColor c)
+{
+    Bitboard king = pos->pieces[c][KING];
+    if (!king)
+    {
+        perror("Could not find king on the board.\n");
+        return NO_SQUARE;
+    }
+    return bb_lsb(king);
+}
+
+void chess_position_print(ChessPosition *pos)
+{
+    ChessGame game = {0};
+    chess_position_to_game(pos, &game);
+    chess_board_print(game.board);
+}
+
+/* castling rights lost when a piece moves from or to the square */
+static const int CASTLING_LOST[CHESS_BOARD_LEN] = {
+    [0] = CASTLE_WHITE_QUEEN,
+    [4] = CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN,
+    [7] = CASTLE_WHITE_KING,
+    [56] = CASTLE_BLACK_QUEEN,
+    [60] = CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN,
+    [63] = CASTLE_BLACK_KING,
+};
+
+void chess_position_make_move(ChessPosition *pos, ChessMove move, ChessUndo *undo)
+{
+    ChessColor us = pos->turn_color;
+    int from = MOVE_FROM(move), to = MOVE_TO(move), flags = MOVE_FLAGS(move);
+    int up = us == WHITE ? CHESS_BOARD_WIDTH : -CHESS_BOARD_WIDTH;
+    undo->move = move;
+    undo->captured = 0;
+    undo->castling = pos->castling;
+    undo->en_passant = pos->en_passant;
+    undo->fifty_move_rule_turn_count = pos->fifty_move_rule_turn_count;
+    undo->key = pos->key;
+
+    if (pos->en_passant != NO_SQUARE)
+        pos->key ^= ZOBRIST_EN_PASSANT[SQUARE_FILE(pos->en_passant)];
+    pos->en_passant = NO_SQUARE;
+    pos->fifty_move_rule_turn_count++;
+    if (flags == MOVE_EN_PASSANT)
+    {
+        undo->captured = pos->squares[to - up];
+        chess_position_remove_piece(pos, to - up);
+    }
+    else if (flags & MOVE_CAPTURE)
+    {
+        undo->captured = pos->squares[to];
+        chess_position_remove_piece(pos, to);
+    }
+    if (undo->captured || POS_TYPE_AT(pos, from) == PAWN)
+        pos->fifty_move_rule_turn_count = 0;
+
+    chess_position_move_piece(pos, from, to);
+    switch (flags)
+    {
+    case MOVE_DOUBLE_PAWN_PUSH:
+        /* only kept when an enemy pawn can take it, so the key does not depend on it otherwise */
+        if (PAWN_ATTACKS[us][from + up] & pos->pieces[!us][PAWN])
+        {
+            pos->en_passant = from + up;
+            pos->key ^= ZOBRIST_EN_PASSANT[SQUARE_FILE(from + up)];
+        }
+        break;
+    case MOVE_KING_CASTLE:
+        chess_position_move_piece(pos, to + 1, to - 1);
+        break;
+    case MOVE_QUEEN_CASTLE:
+        chess_position_move_piece(pos, to - 2, to + 1);
+        break;
+    default:
+        if (flags & MOVE_PROMOTION)
+        {
+            chess_position_remove_piece(pos, to);
+            chess_position_put_piece(pos, to, MOVE_PROMOTION_TYPE(move), us);
+        }
+    }
+    pos->key ^= ZOBRIST_CASTLING[pos->castling];
+    pos->castling &= ~(CASTLING_LOST[from] | CASTLING_LOST[to]);
+    pos->key ^= ZOBRIST_CASTLING[pos->castling] ^ ZOBRIST_TURN;
+    if (us == BLACK)
+        pos->num_turns++;
+    pos->turn_color = !us;
+}
+
+void chess_position_unmake_move(ChessPosition *pos, ChessUndo *undo)
+{
+    ChessMove move = undo->move;
+    ChessColor us = !pos->turn_color;
+    int from = MOVE_FROM(move), to = MOVE_TO(move), flags = MOVE_FLAGS(move);
+    int up = us == WHITE ? CHESS_BOARD_WIDTH : -CHESS_BOARD_WIDTH;
+    pos->turn_color = us;
+    if (us == BLACK)
+        pos->num_turns--;
+
+    if (flags & MOVE_PROMOTION)
+    {
+        chess_position_remove_piece(pos, to);
+        chess_position_put_piece(pos, to, PAWN, us);
+    }
+    chess_position_move_piece(pos, to, from);
+    if (flags == MOVE_KING_CASTLE)
+        chess_position_move_piece(pos, to - 1, to + 1);
+    else if (flags == MOVE_QUEEN_CASTLE)
+        chess_position_move_piece(pos, to + 1, to - 2);
+
+    if (undo->captured)
+    {
+        int sq = flags == MOVE_EN_PASSANT ? to - up : to;
+        chess_position_put_piece(pos, sq, CP_GET_TYPE(undo->captured), CP_GET_COLOR(undo->captured));
+    }
+    pos->castling = undo->castling;
+    pos->en_passant = undo->en_passant;
+    pos->fifty_move_rule_turn_count = undo->fifty_move_rule_turn_count;
+    pos->key = undo->key;
+}
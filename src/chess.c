@@ -2,6 +2,12 @@
 #include <string.h>
 #include <ctype.h>
 #include "../include/chess.h"
+#include "../include/movegen.h"
+#include "../include/attacks.h"
+#include "../include/search.h"
+#include "../include/pack.h"
+#include "../include/san.h"
+#include "../include/book.h"
 
 /*  Define movement vectors for each piece type */
 static const Vec2 PAWN_PASSIVE_MOVES[] = {{0, 1}};
@@ -23,18 +29,6 @@ static const MoveSet MOVE_SETS[] = {
     {{(Vec2 *)KING_MOVES, 8}, {(Vec2 *)KING_MOVES, 8}, 1},                     /*  KING */
 };
 
-#ifdef _WIN32
-
-#define strdup(s) _strdup(s)
-#define strnicmp(a, b, len) _strnicmp(a, b, len)
-
-#else
-
-#define strdup(s) strcpy(malloc(strlen(s) + 1),s)
-#define strnicmp(a,b,len) strncmp(a,b,len)
-
-#endif
-
 
 int char_to_file(char c)
 {
@@ -205,33 +199,44 @@ void chess_board_clear_threats(ChessBoard cb)
     }
 }
 
-void chess_board_set_threats(ChessBoard cb, LegalMoveArray *lma)
+/* marks every piece that the other color attacks in pos */
+void chess_board_set_threats(ChessBoard cb, ChessPosition *pos)
 {
-    int i;
-    for (i = 0; i < lma->len; i++)
+    Bitboard pieces = pos->all;
+    while (pieces)
     {
-        Move move = lma->arr[i].move;
-        Vec2 v = move.v;
-        if (!move.take)
-            continue;
-        if (CP_GET_TYPE(cb[v.x][v.y]) == NONE)
-            continue;
-        if (CP_GET_COLOR(cb[v.x][v.y]) == CP_GET_COLOR(cb[lma->arr[i].origin_sqaure.x][lma->arr[i].origin_sqaure.y]))
-            continue;
-        CP_SET_THREAT(cb[v.x][v.y], 1);
+        int sq = bb_pop_lsb(&pieces);
+        if (chess_position_is_square_attacked(pos, sq, !POS_COLOR_AT(pos, sq)))
+            CP_SET_THREAT(cb[SQUARE_FILE(sq)][SQUARE_RANK(sq)], 1);
     }
 }
 
-/* doesn't set has moved variable */
-void chess_board_move_piece(ChessBoard board, LegalMove move)
+/* doesn't set has moved variable or promote pawns */
+void chess_board_move_piece(ChessBoard board, ChessMove move)
 {
-    LegalMove *tmp = &move;
-    while (tmp != NULL)
+    int x = SQUARE_FILE(MOVE_FROM(move)), y = SQUARE_RANK(MOVE_FROM(move));
+    int dest_x = SQUARE_FILE(MOVE_TO(move)), dest_y = SQUARE_RANK(MOVE_TO(move));
+    ChessPiece piece = CS_GET_PIECE(board[x][y]);
+    CP_SET_TYPE(board[x][y], NONE);
+    CS_SET_PIECE(board[dest_x][dest_y], piece);
+    switch (MOVE_FLAGS(move))
     {
-        ChessPiece piece = CS_GET_PIECE(board[tmp->origin_sqaure.x][tmp->origin_sqaure.y]);
-        CP_SET_TYPE(board[tmp->origin_sqaure.x][tmp->origin_sqaure.y], NONE);
-        CS_SET_PIECE(board[tmp->move.v.x][tmp->move.v.y], piece);
-        tmp = tmp->next;
+    case MOVE_KING_CASTLE:
+        piece = CS_GET_PIECE(board[CHESS_BOARD_WIDTH - 1][y]);
+        CP_SET_TYPE(board[CHESS_BOARD_WIDTH - 1][y], NONE);
+        CS_SET_PIECE(board[dest_x - 1][y], piece);
+        break;
+    case MOVE_QUEEN_CASTLE:
+        piece = CS_GET_PIECE(board[0][y]);
+        CP_SET_TYPE(board[0][y], NONE);
+        CS_SET_PIECE(board[dest_x + 1][y], piece);
+        break;
+    case MOVE_EN_PASSANT:
+        /* the taken pawn is beside the origin */
+        CP_SET_TYPE(board[dest_x][y], NONE);
+        break;
+    default:
+        break;
     }
 }
 
@@ -363,200 +368,38 @@ char type_to_char(ChessPieceType t)
     }
 }
 
-static char move_label_str[128];
-
-const char *generate_move_label(ChessBoard board, LegalMove lm, int force_include_origin_rank, int force_include_origin_file)
+/* the game as a position with color to move */
+static void chess_game_to_position(ChessGame *game, ChessColor color, ChessPosition *pos)
 {
-    Vec2 start_loc = lm.origin_sqaure;
-    Move move = lm.move;
-    int len = 0;
-    char p = type_to_char(CP_GET_TYPE(board[start_loc.x][start_loc.y]));
-    if (p == 'P' && lm.next)
-    {
-        /* en passant */
-        move = lm.next->move;
-        start_loc = lm.next->origin_sqaure;
-    }
-    char take = move.take ? 'x' : 0;
-    char file = start_loc.x + 'a';
-    char rank = start_loc.y + '1';
-    char file_dest = move.v.x + 'a';
-    char rank_dest = move.v.y + '1';
-
-    if (p != 'P')
-    {
-        if (p == 'K' && lm.next)
-        {
-            /* castling */
-            move_label_str[len++] = 'O';
-            move_label_str[len++] = '-';
-            move_label_str[len++] = 'O';
-            if (lm.next->origin_sqaure.x == 0)
-            {
-                /* queen side */
-                move_label_str[len++] = '-';
-                move_label_str[len++] = 'O';
-            }
-            move_label_str[len++] = 0;
-            return move_label_str;
-        }
-        move_label_str[len++] = p;
-    }
-    else if (take)
-    {
-        /* pawn take move */
-        move_label_str[len++] = file;
-        if (force_include_origin_rank)
-            move_label_str[len++] = rank;
-        move_label_str[len++] = take;
-        move_label_str[len++] = file_dest;
-        move_label_str[len++] = rank_dest;
-        move_label_str[len++] = 0;
-        return move_label_str;
-    }
-    if (force_include_origin_file)
-        move_label_str[len++] = file;
-    if (force_include_origin_rank)
-        move_label_str[len++] = rank;
-    if (take)
+    chess_position_from_game(pos, game);
+    if (pos->turn_color != color)
     {
-        /* take move */
-        move_label_str[len++] = take;
+        /* only the player to move can take en passant */
+        pos->turn_color = color;
+        pos->en_passant = NO_SQUARE;
     }
-    move_label_str[len++] = file_dest;
-    move_label_str[len++] = rank_dest;
-    move_label_str[len++] = 0;
-    return move_label_str;
 }
 
-#define MAX_MOVES 300
-
-LegalMoveArray *generate_legal_moves(ChessGame *game, ChessColor turn_color)
+void generate_legal_moves(ChessGame *game, ChessColor turn_color, MoveList *ret)
 {
-    int x, y;
-    LegalMoveArray *ret = (LegalMoveArray *)malloc(sizeof(LegalMoveArray));
-    int cap = 10;
-    ret->arr = (LegalMove *)malloc(sizeof(LegalMove) * cap);
-    ret->len = 0;
-    Move moves[MAX_MOVES];
-    int moves_len = 0;
-    for (x = 0; x < CHESS_BOARD_WIDTH; x++)
-    {
-        for (y = 0; y < CHESS_BOARD_HEIGHT; y++)
-        {
-            if (CP_GET_TYPE(game->board[x][y]) == NONE)
-                continue;
-            if (CP_GET_COLOR(game->board[x][y]) != turn_color)
-                continue;
-            moves_len = 0;
-            generate_moves(game->board, x, y, moves, &moves_len);
-            if (!moves_len)
-                continue;
-            int i;
-            for (i = 0; i < moves_len; i++)
-            {
-                if (ret->len >= cap)
-                {
-                    cap *= 2;
-                    LegalMove *tmp = (LegalMove *)realloc(ret->arr, sizeof(LegalMove) * cap);
-                    if (!tmp)
-                    {
-                        perror("Could not allocate more memory in 'generate_legal_moves'\n");
-                        exit(1);
-                    }
-                    ret->arr = tmp;
-                }
-                ret->arr[ret->len].move = moves[i];
-                ret->arr[ret->len].next = NULL;
-                ret->arr[ret->len++].origin_sqaure = (Vec2){x, y};
-            }
-            /* en passant */
-            if (CP_GET_TYPE(game->board[x][y]) != PAWN)
-                continue;
-            if ((turn_color == WHITE && y == 4) || (turn_color == BLACK && y == 3))
-            {
-                int dir = (turn_color == BLACK ? -1 : 1);
-                ChessSquare sq;
-                /* check if there is a pawn to the left or right */
-                if (x - 1 >= 0)
-                { /* check the left */
-                    sq = game->board[x - 1][y];
-                    if (CP_GET_TYPE(sq) == PAWN && CP_GET_HAS_MOVED(sq) == 0 && CP_GET_COLOR(sq) != turn_color)
-                    {
-                        /* can en passant */
-                        LegalMove move_enemy_back = {.move = {.take = 0, .v = {x - 1, y + dir}}, .origin_sqaure = {x - 1, y}};
-                        LegalMove take_pawn = {.move = move_enemy_back.move, .origin_sqaure = {x, y}};
-                        take_pawn.move.take = 1;
-                        legal_move_add_next(&move_enemy_back, take_pawn);
-                        if (ret->len >= cap)
-                        {
-                            cap *= 2;
-                            LegalMove *tmp = (LegalMove *)realloc(ret->arr, sizeof(LegalMove) * cap);
-                            if (!tmp)
-                            {
-                                perror("Could not allocate more memory in 'generate_legal_moves'\n");
-                                exit(1);
-                            }
-                            ret->arr = tmp;
-                        }
-                        ret->arr[ret->len++] = move_enemy_back;
-                    }
-                }
-                if (x + 1 < CHESS_BOARD_WIDTH)
-                { /* check the right */
-                    sq = game->board[x + 1][y];
-                    if (CP_GET_TYPE(sq) == PAWN && CP_GET_HAS_MOVED(sq) == 0 && CP_GET_COLOR(sq) != turn_color)
-                    {
-                        /* can en passant */
-                        LegalMove move_enemy_back = {.move = {.take = 0, .v = {x + 1, y + dir}}, .origin_sqaure = {x + 1, y}};
-                        LegalMove take_pawn = {.move = move_enemy_back.move, .origin_sqaure = {x, y}};
-                        take_pawn.move.take = 1;
-                        legal_move_add_next(&move_enemy_back, take_pawn);
-                        if (ret->len >= cap)
-                        {
-                            cap *= 2;
-                            LegalMove *tmp = (LegalMove *)realloc(ret->arr, sizeof(LegalMove) * cap);
-                            if (!tmp)
-                            {
-                                perror("Could not allocate more memory in 'generate_legal_moves'\n");
-                                exit(1);
-                            }
-                            ret->arr = tmp;
-                        }
-                        ret->arr[ret->len++] = move_enemy_back;
-                    }
-                }
-            }
-        }
-    }
-    LegalMove *tmp = (LegalMove *)realloc(ret->arr, sizeof(LegalMove) * ret->len);
-    if (!tmp)
-    {
-        perror("Could not clamp memory in 'generate_legal_moves'\n");
-        exit(1);
-    }
-    ret->arr = tmp;
-    return ret;
+    ChessPosition pos;
+    chess_game_to_position(game, turn_color, &pos);
+    chess_position_generate_legal_moves(&pos, ret);
 }
 
-/* returns index in labels of input, returns -1 if can't find */
-int chess_game_parse_input(char *_input, StrArray labels)
+/* returns the index of the move input names, by its number in the printed list or any text index holds.
+    Returns SAN_NO_MATCH if it names no move and SAN_AMBIGUOUS if it could be more than one.
+*/
+int chess_game_parse_input(char *_input, MoveIndex *index, int len)
 {
     if (!_input)
-        return -1;
-    size_t input_len = strlen(_input);
-    if (!input_len)
-        return -1;
-    if (isdigit(_input[0]))
-        return atoi(_input) - 1;
-    int i;
-    /* O(n^2) */
-    for (i = 0; i < labels.len; i++)
-    {
-        if (strnicmp(_input, labels.arr[i], input_len) == 0)
-            return i;
-    }
-    return -1;
+        return SAN_NO_MATCH;
+    /* before the numbers, 0-0 is castling */
+    int x = move_index_find(index, _input);
+    if (x != SAN_NO_MATCH || !isdigit(_input[0]))
+        return x;
+    x = atoi(_input) - 1;
+    return x >= 0 && x < len ? x : SAN_NO_MATCH;
 }
 
 void chess_game_print_turn_flair(ChessGame *game)
@@ -564,13 +407,13 @@ void chess_game_print_turn_flair(ChessGame *game)
     printf("Turn %d, %s to move.\n", game->data.num_turns + 1, game->data.turn_color == WHITE ? "White" : "Black");
 }
 
-void chess_game_print_moves(StrArray *labels, int row_max)
+void chess_game_print_moves(SanList *labels, int row_max)
 {
     int i, tmp = 0;
     for (i = 0; i < labels->len; i++)
     {
         tmp = 0;
-        printf("%3d. %-5s ", i + 1, labels->arr[i]);
+        printf("%3d. %-5s ", i + 1, labels->labels[i]);
         if (i && ((i + 1) % row_max) == 0)
         {
             printf("\n");
@@ -585,87 +428,17 @@ void chess_game_print_moves(StrArray *labels, int row_max)
         printf("\n");
 }
 
-typedef struct
-{
-    int a, b;
-} IntPair;
-
-/* returns indexes of first value with duplicates */
-IntPair *find_duplicates(StrArray *labels, int *ret_len)
-{
-    IntPair *ret = (IntPair *)malloc(sizeof(int) * labels->len);
-    int i, j, len = 0;
-    for (i = 0; i < labels->len; i++)
-    {
-        for (j = i + 1; j < labels->len; j++)
-        {
-            if (i == j)
-                continue;
-            if (strcmp(labels->arr[i], labels->arr[j]) == 0)
-            {
-                ret[len++] = (IntPair){i, j};
-            }
-        }
-    }
-    *ret_len = len;
-    if (!len)
-    {
-        free(ret);
-        return NULL;
-    }
-    return ret;
-}
+static void chess_game_generate_turn_moves(ChessGame *game, ChessPosition *pos, MoveList *list);
 
-/* expects labels array to have the capacity to hold lma and that the len is equal
-        This function can undoubtably be optimized
+/* returns the index of the move, which is the same for list and labels.
+    Function also populates the labels array and index. A loaded game replaces game and pos.
 */
-void populate_labels(StrArray *labels, ChessGame *game, LegalMoveArray *lma)
-{
-    int i;
-    for (i = 0; i < lma->len; i++)
-    {
-        labels->arr[i] = strdup(generate_move_label(game->board, lma->arr[i], 0, 0));
-    }
-    int len = -1;
-    IntPair *dups = find_duplicates(labels, &len);
-    while (dups != NULL)
-    { /* check if the pieces are in the same file,
-        if they are not then just add the files,
-        if they are then add the rank also */
-        for (i = 0; i < len; i++)
-        {
-            IntPair pair = dups[i];
-            if (strcmp(labels->arr[pair.a], labels->arr[pair.b]) != 0)
-                continue;
-            Vec2 v0 = lma->arr[pair.a].origin_sqaure;
-
-            Vec2 v1 = lma->arr[pair.b].origin_sqaure;
-            free(labels->arr[pair.a]);
-            free(labels->arr[pair.b]);
-            if (v0.x == v1.x) /* compare files */
-            {
-                labels->arr[pair.a] = strdup(generate_move_label(game->board, lma->arr[pair.a], 1, 1));
-                labels->arr[pair.b] = strdup(generate_move_label(game->board, lma->arr[pair.b], 1, 1));
-            }
-            else
-            {
-                labels->arr[pair.a] = strdup(generate_move_label(game->board, lma->arr[pair.a], 0, 1));
-                labels->arr[pair.b] = strdup(generate_move_label(game->board, lma->arr[pair.b], 0, 1));
-            }
-        }
-        free(dups);
-        dups = find_duplicates(labels, &len);
-    }
-}
-
-/* returns the index of the move, which is the same for lma and labels.
-    Function also populates the labels array.
-*/
-int chess_game_get_move_idx_from_user(ChessGame *game, LegalMoveArray **lma, StrArray *labels)
+static int chess_game_get_move_idx_from_user(ChessGame *game, ChessPosition *pos, MoveList *list, SanList *labels, MoveIndex *index)
 {
     const int row_max = 5;
 load_game:
-    populate_labels(labels, game, *lma);
+    chess_position_moves_to_san(pos, list, labels);
+    move_index_build(index, pos, list, labels);
 select_move:
     chess_game_print_moves(labels, row_max);
     chess_board_print(game->board);
@@ -674,13 +447,11 @@ select_move:
     char *inp = input('\n', &len);
     if (inp == strstr(inp, "quit"))
     {
-        free_legal_move_array(*lma);
-        free_str_array(*labels);
         return -1;
     }
     if (inp == strstr(inp, "rand"))
     {
-        return rand() % (*lma)->len;
+        return rand() % list->len;
     }
     if (inp == strstr(inp, "save "))
     {
@@ -692,24 +463,17 @@ select_move:
         chess_game_deserialize(game, inp + 5);
         printf("Turn %d, %s to move.\n", game->data.num_turns, game->data.turn_color == WHITE ? "White" : "Black");
         chess_board_print(game->board);
-        free_legal_move_array(*lma);
-        *lma = generate_legal_moves(game, game->data.turn_color);
-        int check = chess_game_is_king_in_check(game, game->data.turn_color);
-        if (check)
-        {
-            remove_illegal_moves_while_in_check(game, *lma);
-        }
-        else
-        {
-            add_castle_move(game, *lma);
-        }
-        free_str_array(*labels);
-        labels->len = (*lma)->len;
-        labels->arr = (char **)malloc(sizeof(char *) * (*lma)->len);
+        chess_position_from_game(pos, game);
+        chess_game_generate_turn_moves(game, pos, list);
         goto load_game;
     }
-    int x = chess_game_parse_input(inp, *labels);
-    if (x == -1)
+    int x = chess_game_parse_input(inp, index, list->len);
+    if (x == SAN_AMBIGUOUS)
+    {
+        printf("More than one move fits, add the file or rank the piece moves from.\n");
+        goto select_move;
+    }
+    if (x == SAN_NO_MATCH)
     {
         printf("Please choose a move from the list.\n");
         goto select_move;
@@ -717,19 +481,16 @@ select_move:
     return x;
 }
 
-void chess_game_update(ChessGame *game, StrArray labels, int x, FILE *pgn_file)
+void chess_game_update(ChessGame *game, const char *label, FILE *pgn_file)
 {
-    static int i = 0;
     if (game->data.turn_color == WHITE)
-        fprintf(pgn_file, "%d. %s ", game->data.num_turns + 1, labels.arr[x]);
+        fprintf(pgn_file, "%d. %s ", game->data.num_turns + 1, label);
     else
-        fprintf(pgn_file, "%s\n", labels.arr[x]);
+        fprintf(pgn_file, "%s\n", label);
     fflush(pgn_file);
-    if (++i % 2 == 0)
-    {
+    /* a turn is over once black has moved */
+    if (game->data.turn_color == BLACK)
         game->data.num_turns++;
-        i = 0;
-    }
     game->data.turn_color = !game->data.turn_color;
     Vec2 white_king_loc = chess_board_find_king(game->board, WHITE);
     ChessPiece white_king = game->board[white_king_loc.x][white_king_loc.y];
@@ -757,84 +518,26 @@ void chess_game_update(ChessGame *game, StrArray labels, int x, FILE *pgn_file)
 
 int chess_game_is_king_in_check(ChessGame *game, ChessColor c)
 {
-    Vec2 loc = chess_board_find_king(game->board, c);
-    return CP_GET_IS_IN_THREAT(game->board[loc.x][loc.y]);
+    ChessPosition pos;
+    chess_position_from_game(&pos, game);
+    return chess_position_in_check(&pos, c);
 }
 
-/* copies game to ret_saved_game*/
-void chess_game_save_state(ChessGame *game, ChessGame *ret_saved_game)
+/* clears the threats and marks the pieces each color attacks */
+void chess_game_update_threats(ChessGame *game)
 {
-    ret_saved_game->data = game->data;
-    int i, j;
-    for (i = 0; i < CHESS_BOARD_WIDTH; i++)
-    {
-        for (j = 0; j < CHESS_BOARD_HEIGHT; j++)
-        {
-            ret_saved_game->board[i][j] = game->board[i][j];
-        }
-    }
-}
-
-/* copies saved game to game. */
-void chess_game_load_state(ChessGame *game, ChessGame *saved_game)
-{
-    memcpy(game, saved_game, sizeof(ChessGame));
-}
-
-/* doesn't clear threats */
-void chess_game_update_threats(ChessGame *game, ChessColor color)
-{
-    /* update the threats to see if we are in threat now */
-    LegalMoveArray *lma_tmp = generate_legal_moves(game, color);
-    chess_board_set_threats(game->board, lma_tmp);
-    free_legal_move_array(lma_tmp);
-}
-
-void chess_game_handle_pawn_promotion(ChessGame *game)
-{
-    int i, row = (game->data.turn_color == BLACK) ? 0 : (CHESS_BOARD_HEIGHT - 1);
-    for (i = 0; i < CHESS_BOARD_WIDTH; i++)
-    {
-        if (CP_GET_COLOR(game->board[i][row]) != game->data.turn_color)
-            continue;
-        if (CP_GET_TYPE(game->board[i][row]) == PAWN)
-            CP_SET_TYPE(game->board[i][row], QUEEN);
-    }
+    ChessPosition pos;
+    chess_position_from_game(&pos, game);
+    chess_board_clear_threats(game->board);
+    chess_board_set_threats(game->board, &pos);
 }
 
-void remove_illegal_moves_while_in_check(ChessGame *game, LegalMoveArray *lma)
+/* promotes the pawn to the piece the move chose */
+void chess_game_handle_pawn_promotion(ChessGame *game, ChessMove move)
 {
-    LegalMoveArray new_lma = {(LegalMove *)malloc(sizeof(LegalMove) * lma->len), 0};
-    int i;
-    for (i = 0; i < lma->len; i++)
-    {
-        ChessGame tmp_game;
-        chess_game_load_state(&tmp_game, game);
-        chess_board_move_piece(tmp_game.board, lma->arr[i]);
-        chess_board_clear_threats(tmp_game.board);
-        chess_game_update_threats(&tmp_game, !tmp_game.data.turn_color);
-        chess_game_update_threats(&tmp_game, tmp_game.data.turn_color);
-        /* printf("Move %d\n",i);
-         chess_board_visualize(tmp_game.board);
-        chess_board_print(tmp_game.board); */
-        int check = chess_game_is_king_in_check(&tmp_game, tmp_game.data.turn_color);
-        if (!check)
-            new_lma.arr[new_lma.len++] = lma->arr[i];
-    }
-    free_legal_move_array(lma);
-    if (!new_lma.len) 
-    {
-        *lma = new_lma;
-        return;
-    }
-    LegalMove *tmp = (LegalMove *)realloc(new_lma.arr, new_lma.len * sizeof(LegalMove));
-    if (!tmp)
-    {
-        perror("Could not clamp lma in 'remove_illegal_moves_while_in_check'\n");
-        exit(1);
-    }
-    new_lma.arr = tmp;
-    *lma = new_lma;
+    int x = SQUARE_FILE(MOVE_TO(move)), y = SQUARE_RANK(MOVE_TO(move));
+    if (MOVE_IS_PROMOTION(move) && CP_GET_TYPE(game->board[x][y]) == PAWN)
+        CP_SET_TYPE(game->board[x][y], MOVE_PROMOTION_TYPE(move));
 }
 
 typedef struct
@@ -865,124 +568,84 @@ OptionalVec2 chess_board_find_piece(ChessBoard cb, ChessPieceType t, ChessColor
     return ret;
 }
 
-void add_castle_move(ChessGame *game, LegalMoveArray *lma)
-{
-    Vec2 king_loc = chess_board_find_king(game->board, game->data.turn_color);
-    ChessSquare king_sq = game->board[king_loc.x][king_loc.y];
-    if (CP_GET_HAS_MOVED(king_sq))
-        return;
-    if (CP_GET_WAS_IN_THREAT(king_sq))
-        return;
-    int y = 0;
-    if (game->data.turn_color == BLACK)
-        y = CHESS_BOARD_HEIGHT - 1;
-    int i;
-    /* queen side */
-    ChessSquare rook_sq = game->board[0][y];
-    if (CP_GET_TYPE(rook_sq) == ROOK && CP_GET_HAS_MOVED(rook_sq) == 0)
-    {
-        /* check if there are pieces between us and the king */
-        for (i = 1; i < king_loc.x; i++)
-        {
-            if (CP_GET_TYPE(game->board[i][y]) != NONE)
-                goto skip_queen_side;
-        }
-        LegalMove king_move = {.move = {.take = 0, .v = {2, y}}, .origin_sqaure = king_loc},
-                  rook_move = {.move = {.take = 0, .v = {3, y}}, .origin_sqaure = {0, y}};
-        legal_move_add_next(&king_move, rook_move);
-        LegalMove *tmp = (LegalMove *)realloc(lma->arr, (lma->len + 1) * sizeof(LegalMove));
-        if (!tmp)
-        {
-            perror("Could not realloc lma in 'add_castle_move'\n");
-            exit(1);
-        }
-        lma->arr = tmp;
-        lma->arr[lma->len++] = king_move;
-        /*
-                TODO:
-                        add castle queen side to lma
-        */
-    }
-skip_queen_side:
-    /* king side */
-    rook_sq = game->board[CHESS_BOARD_WIDTH - 1][y];
-    if (CP_GET_TYPE(rook_sq) == ROOK && CP_GET_HAS_MOVED(rook_sq) == 0)
-    {
-        /* check if there are pieces between us and the king */
-        for (i = king_loc.x + 1; i < CHESS_BOARD_WIDTH - 1; i++)
-        {
-            if (CP_GET_TYPE(game->board[i][y]) != NONE)
-                return;
-        }
-        LegalMove king_move = {.move = {.take = 0, .v = {6, y}}, .origin_sqaure = king_loc},
-                  rook_move = {.move = {.take = 0, .v = {5, y}}, .origin_sqaure = {CHESS_BOARD_WIDTH - 1, y}};
-        legal_move_add_next(&king_move, rook_move);
-        LegalMove *tmp = (LegalMove *)realloc(lma->arr, (lma->len + 1) * sizeof(LegalMove));
-        if (!tmp)
-        {
-            perror("Could not realloc lma in 'add_castle_move'\n");
-            exit(1);
-        }
-        lma->arr = tmp;
-        lma->arr[lma->len++] = king_move;
-        /*
-                TODO:
-                        add castle king side to lma
-        */
-    }
-}
-
-void chess_game_set_moved(ChessGame *game, LegalMove lm)
+void chess_game_set_moved(ChessGame *game, ChessMove move)
 {
-    Vec2 v = lm.move.v;
-    CP_SET_HAS_MOVED(game->board[v.x][v.y], 1);
-    if (lm.next)
-    {
-        LegalMove *node = lm.next;
-        while (node != NULL)
-        {
-            v = node->move.v;
-            CP_SET_HAS_MOVED(game->board[v.x][v.y], 1);
-            node = node->next;
-        }
-    }
+    int x = SQUARE_FILE(MOVE_TO(move)), y = SQUARE_RANK(MOVE_TO(move));
+    CP_SET_HAS_MOVED(game->board[x][y], 1);
+    /* the rook lands beside the king */
+    if (MOVE_FLAGS(move) == MOVE_KING_CASTLE)
+        CP_SET_HAS_MOVED(game->board[x - 1][y], 1);
+    else if (MOVE_FLAGS(move) == MOVE_QUEEN_CASTLE)
+        CP_SET_HAS_MOVED(game->board[x + 1][y], 1);
 }
 
 void chess_game_serialize(ChessGame *game, char *filename)
 {
+    unsigned char buf[CHESS_PACK_HEADER_LEN + CHESS_PACKED_LEN];
     FILE *f = fopen(filename, "wb");
     if (!f)
     {
         fprintf(stderr, "Failed to open file '%s'\n", filename);
         return;
     }
-    fwrite(&game->data, sizeof(game->data), 1, f);
-    fwrite(game->board, sizeof(ChessSquare), CHESS_BOARD_LEN, f);
+    chess_pack_write_header(buf);
+    chess_game_pack(game, (ChessPackedPosition *)(buf + CHESS_PACK_HEADER_LEN));
+    if (fwrite(buf, 1, sizeof(buf), f) != sizeof(buf))
+        perror("Failed to write game to file.\n");
     fclose(f);
 }
 
+/* ChessBoardData as the old raw dumps laid it out, 7 little endian ints.
+    Older dumps have up to two more ints after them (the en passant file), which are skipped.
+*/
+#define CHESS_LEGACY_DATA_LEN 28
+#define CHESS_LEGACY_DATA_MAX_LEN 36
+
+/* reads a little endian 32 bit int */
+static int chess_read_legacy_int(const unsigned char *b)
+{
+    return (int)((unsigned)b[0] | ((unsigned)b[1] << 8) | ((unsigned)b[2] << 16) | ((unsigned)b[3] << 24));
+}
+
+/* files written before the packed format are a raw ChessBoardData followed by the ChessBoard */
+static void chess_game_from_legacy_dump(ChessGame *game, const unsigned char *b, size_t data_len)
+{
+    game->data.turn_color = chess_read_legacy_int(b) ? WHITE : BLACK;
+    game->data.num_turns = chess_read_legacy_int(b + 4);
+    game->data.fifty_move_rule_turn_count = chess_read_legacy_int(b + 8);
+    game->data.king_in_check.black = chess_read_legacy_int(b + 12);
+    game->data.king_in_check.white = chess_read_legacy_int(b + 16);
+    game->data.king_was_checked.black = chess_read_legacy_int(b + 20);
+    game->data.king_was_checked.white = chess_read_legacy_int(b + 24);
+    memcpy(game->board, b + data_len, CHESS_BOARD_LEN);
+}
+
 void chess_game_deserialize(ChessGame *ret_game, char *filename)
 {
+    unsigned char buf[CHESS_LEGACY_DATA_MAX_LEN + CHESS_BOARD_LEN + 1];
     FILE *f = fopen(filename, "rb");
     if (!f)
     {
         fprintf(stderr, "Failed to open file '%s'\n", filename);
         return;
     }
-    size_t len = fread(&(ret_game->data), sizeof(ChessBoardData), 1, f);
-    if (len != 1)
+    size_t len = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    if (memcmp(buf, CHESS_PACK_MAGIC, 4) != 0 && len >= CHESS_LEGACY_DATA_LEN + CHESS_BOARD_LEN &&
+        len <= CHESS_LEGACY_DATA_MAX_LEN + CHESS_BOARD_LEN && len % 4 == 0)
     {
-        perror("Failed to read ChessBoardData from file.\n");
-        goto file_clean_up;
+        chess_game_from_legacy_dump(ret_game, buf, len - CHESS_BOARD_LEN);
+        return;
     }
-    len = fread((ret_game->board), sizeof(ChessSquare), CHESS_BOARD_LEN, f);
-    if (len != CHESS_BOARD_LEN)
+    if (len < CHESS_PACK_HEADER_LEN + CHESS_PACKED_LEN)
     {
-        perror("Failed to read ChessBoard from from.\n");
-        goto file_clean_up;
+        fprintf(stderr, "'%s' is too short to hold a game\n", filename);
+        return;
     }
-file_clean_up:
-    fclose(f);
+    if (chess_pack_check_header(buf, filename) < 0)
+        return;
+    if (chess_game_unpack(ret_game, (ChessPackedPosition *)(buf + CHESS_PACK_HEADER_LEN)) < 0)
+        fprintf(stderr, "'%s' does not hold a legal position\n", filename);
 }
 
 void update_enemy_pawn_has_moved(ChessGame *game)
@@ -1003,97 +666,112 @@ void update_enemy_pawn_has_moved(ChessGame *game)
     }
 }
 
-void chess_game_start(ChessGame *start_data, int enable_ai, ChessColor ai_color)
+/* generates the moves the player to move can choose from this turn into list, pos must be the same position as game.
+    Also marks the enemy pawns that have moved, after the moves are generated so en passant is possible.
+*/
+static void chess_game_generate_turn_moves(ChessGame *game, ChessPosition *pos, MoveList *list)
+{
+    chess_position_generate_legal_moves(pos, list);
+    /* update late to enable en passant */
+    update_enemy_pawn_has_moved(game);
+}
+
+/* plays a legal move for the player to move, the turn color is not changed. */
+void chess_game_play_move(ChessGame *game, ChessMove move)
+{
+    chess_board_move_piece(game->board, move);
+    /* set has moved */
+    Vec2 loc = {SQUARE_FILE(MOVE_TO(move)), SQUARE_RANK(MOVE_TO(move))};
+    if (!(CP_GET_TYPE(game->board[loc.x][loc.y]) == PAWN && CP_GET_HAS_MOVED(game->board[loc.x][loc.y]) == 0))
+    {
+        chess_game_set_moved(game, move);
+    }
+    chess_game_handle_pawn_promotion(game, move);
+    /* update how the pieces threaten each other on the board */
+    chess_game_update_threats(game);
+}
+
+void chess_game_start(ChessGame *start_data, int enable_ai, ChessColor ai_color, PolyglotBook *book)
 {
-    ChessGame game = start_data ? *start_data : (ChessGame){0}, tmp_game = {0};
+    ChessGame game = start_data ? *start_data : (ChessGame){0};
     FILE *pgn_file = fopen("move_history.pgn", "w");
     chess_board_init(game.board);
     game.data.turn_color = WHITE;
+    /* kept in step with game, its key identifies the position */
+    ChessPosition pos;
+    ChessUndo undo;
+    chess_position_from_game(&pos, &game);
+    /* kept between the AI's moves */
+    TranspositionTable tt;
+    PawnTables pawns;
+    if (enable_ai)
+    {
+        transposition_table_init(&tt, TT_DEFAULT_MB);
+        pawn_tables_init(&pawns);
+    }
+    MoveIndex index;
+    move_index_init(&index);
     printf("Input 'quit' to close.\n");
     while (1)
     {
         /* chess_board_print(game.board); */
-        int in_check_before_move = chess_game_is_king_in_check(&game, game.data.turn_color);
-        LegalMoveArray *lma = generate_legal_moves(&game, game.data.turn_color);
-        if (lma->len == 0)
+        int in_check_before_move = chess_position_in_check(&pos, pos.turn_color);
+        MoveList list;
+        chess_game_generate_turn_moves(&game, &pos, &list);
+        if (list.len == 0)
         {
             if (in_check_before_move)
-            {
                 printf("Checkmate, %s wins.\n", game.data.turn_color != WHITE ? "White" : "Black");
-            }
-            printf("Stalemate; No moves left for %s.\n", game.data.turn_color == WHITE ? "White" : "Black");
-            break;
-        }
-        if (in_check_before_move)
-        {
-            remove_illegal_moves_while_in_check(&game, lma);
-        }
-        else
-        {
-            add_castle_move(&game, lma);
-        }
-        if (lma->len == 0)
-        {
-            printf("Checkmate, %s wins.\n",game.data.turn_color != WHITE ? "White" : "Black");
+            else
+                printf("Stalemate; No moves left for %s.\n", game.data.turn_color == WHITE ? "White" : "Black");
             break;
         }
 
-        StrArray labels = {(char **)malloc(sizeof(char *) * lma->len), lma->len};
-        chess_game_save_state(&game, &tmp_game);
-        /* update late to enable en passant */
-        update_enemy_pawn_has_moved(&game);
-    get_move:
+        SanList labels;
         chess_game_print_turn_flair(&game);
         if (in_check_before_move)
             printf("Your King is in check.\n");
         int x;
-        if (ai_color == game.data.turn_color && enable_ai)
-        {
-            x = rand() % lma->len;
-            populate_labels(&labels, &game, lma);
+        /* the book move, if there is one, is played without searching */
+        ChessMove book_move = MOVE_NONE;
+        if (ai_color == game.data.turn_color && enable_ai && book)
+            book_move = polyglot_book_pick(book, &pos, ((uint64_t)rand() << 31) ^ (uint64_t)rand());
+        if (book_move != MOVE_NONE && (x = move_list_find(&list, book_move)) != -1)
+        {
+            printf("Book move.\n");
+            chess_position_move_to_san(&pos, &list, list.moves[x], labels.labels[x]);
+        }
+        else if (ai_color == game.data.turn_color && enable_ai)
+        {
+            SearchLimits limits = {0, SEARCH_DEFAULT_MOVE_TIME, 0};
+            SearchResult result;
+            chess_position_search(&pos, &limits, &tt, &pawns, &result);
+            printf("Searched to depth %d, score %d, %llu nodes in %.2fs.\n", result.depth, result.score, result.nodes, result.time);
+            x = move_list_find(&list, result.best_move);
+            /* a search that returns no move, or one that isn't legal here, plays the first legal move */
+            if (x == -1)
+                x = 0;
+            chess_position_move_to_san(&pos, &list, list.moves[x], labels.labels[x]);
         }
         else
         {
-            x = chess_game_get_move_idx_from_user(&game, &lma, &labels);
+            x = chess_game_get_move_idx_from_user(&game, &pos, &list, &labels, &index);
             if (x == -1)
                 break;
         }
         printf("Chose %d.\n", x + 1);
-        chess_board_move_piece(game.board, lma->arr[x]);
+        chess_game_play_move(&game, list.moves[x]);
+        chess_position_make_move(&pos, list.moves[x], &undo);
         chess_board_print(game.board);
-        /* update the threats to see if we are in threat now */
-        chess_board_clear_threats(game.board);
-        chess_game_update_threats(&game, !game.data.turn_color);
-        int in_check_after_move = chess_game_is_king_in_check(&game, game.data.turn_color);
-        if (in_check_after_move)
-        {
-            chess_game_load_state(&game, &tmp_game);
-            if (in_check_before_move)
-            {
-                printf("You must move out of check or block it before you can move other pieces.\n");
-                goto get_move;
-            }
-            printf("You cannot move your King into check.\n");
-            goto get_move;
-        }
-        /* set has moved */
-        Vec2 loc = lma->arr[x].move.v;
-        if (!(CP_GET_TYPE(game.board[loc.x][loc.y]) == PAWN && CP_GET_HAS_MOVED(game.board[loc.x][loc.y]) == 0))
-        {
-            chess_game_set_moved(&game, lma->arr[x]);
-        }
-
-        /* promote pawns to queens */
-        chess_game_handle_pawn_promotion(&game);
-        /* update how the current players pieces threaten the others on the board */
-        chess_game_update_threats(&game, game.data.turn_color);
         /* turn color changes */
-        chess_game_update(&game, labels, x, pgn_file);
-
-        printf("\t%s\n", labels.arr[x]);
+        chess_game_update(&game, labels.labels[x], pgn_file);
 
-        free_legal_move_array(lma);
-        free_str_array(labels);
+        printf("\t%s\n", labels.labels[x]);
+    }
+    if (enable_ai)
+    {
+        transposition_table_free(&tt);
+        pawn_tables_free(&pawns);
     }
     fclose(pgn_file);
 }
@@ -1103,7 +781,7 @@ void chess_game_start(ChessGame *start_data, int enable_ai, ChessColor ai_color)
         1. Pawn Promotion (Done? Queen only.)
         2. Castling (Done?)
         3. Check (Done?)
-        *4. Point counting (Piece values)
+        4. Point counting (Piece values) (Done, eval.c)
         *5. Move Timer
         6. Checkmate (Done?)
         7. Edge cases with pgn notation (Done?)
@@ -1,3 +1,10 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L
+#include <time.h>
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
 #include "../include/common.h"
 
 /* gets from stdin*/
@@ -49,4 +56,30 @@ void free_str_array(StrArray str_array)
                 free(str_array.arr[i]);
         }
         free(str_array.arr);
-}
\ No newline at end of file
+}
+
+double get_time(void)
+{
+#ifdef _WIN32
+        LARGE_INTEGER freq, count;
+        QueryPerformanceFrequency(&freq);
+        QueryPerformanceCounter(&count);
+        return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+int get_cpu_count(void)
+{
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        return n > 0 ? (int)n : 1;
+#endif
+}
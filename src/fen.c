@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <string.h>
+#include "../include/fen.h"
+#include "../include/zobrist.h"
+#include "../include/movegen.h"
+
+/* FEN letter of each ChessPieceType in white, lowercase is black */
+static const char FEN_PIECE_CHARS[KING + 1] = {
+    [NONE] = '?',
+    [PAWN] = 'P',
+    [BISHOP] = 'B',
+    [KNIGHT] = 'N',
+    [ROOK] = 'R',
+    [QUEEN] = 'Q',
+    [KING] = 'K',
+};
+
+static ChessPieceType fen_char_to_type(char c)
+{
+    switch (c | 0x20)
+    {
+    case 'p':
+        return PAWN;
+    case 'b':
+        return BISHOP;
+    case 'n':
+        return KNIGHT;
+    case 'r':
+        return ROOK;
+    case 'q':
+        return QUEEN;
+    case 'k':
+        return KING;
+    default:
+        return NONE;
+    }
+}
+
+/* reads a number of at most 9 digits, returns -1 if there isn't one */
+static int fen_read_number(const char **s)
+{
+    const char *c = *s;
+    int n = 0;
+    if (*c < '0' || *c > '9')
+        return -1;
+    while (*c >= '0' && *c <= '9' && c - *s < 9)
+        n = n * 10 + (*c++ - '0');
+    *s = c;
+    return n;
+}
+
+int chess_position_from_fen(ChessPosition *pos, const char *fen)
+{
+    const char *c = fen;
+    int x = 0, y = CHESS_BOARD_HEIGHT - 1;
+    chess_position_clear(pos);
+    while (*c == ' ')
+        c++;
+    /* placement, rank 8 first */
+    for (; *c && *c != ' '; c++)
+    {
+        if (*c == '/')
+        {
+            if (x != CHESS_BOARD_WIDTH || y == 0)
+                return -1;
+            x = 0;
+            y--;
+        }
+        else if (*c >= '1' && *c <= '8')
+        {
+            x += *c - '0';
+            if (x > CHESS_BOARD_WIDTH)
+                return -1;
+        }
+        else
+        {
+            ChessPieceType type = fen_char_to_type(*c);
+            if (type == NONE || x >= CHESS_BOARD_WIDTH)
+                return -1;
+            chess_position_put_piece(pos, SQUARE(x, y), type, *c >= 'a' ? BLACK : WHITE);
+            x++;
+        }
+    }
+    if (x != CHESS_BOARD_WIDTH || y != 0)
+        return -1;
+    /* side to move */
+    if (*c++ != ' ' || (*c != 'w' && *c != 'b'))
+        return -1;
+    pos->turn_color = *c++ == 'w' ? WHITE : BLACK;
+    if (!chess_position_is_valid(pos))
+        return -1;
+    /* castling */
+    if (*c++ != ' ')
+        return -1;
+    if (*c == '-')
+        c++;
+    else
+    {
+        for (; *c && *c != ' '; c++)
+        {
+            switch (*c)
+            {
+            case 'K':
+                pos->castling |= CASTLE_WHITE_KING;
+                break;
+            case 'Q':
+                pos->castling |= CASTLE_WHITE_QUEEN;
+                break;
+            case 'k':
+                pos->castling |= CASTLE_BLACK_KING;
+                break;
+            case 'q':
+                pos->castling |= CASTLE_BLACK_QUEEN;
+                break;
+            default:
+                return -1;
+            }
+        }
+    }
+    chess_position_trim_castling(pos);
+    /* en passant */
+    if (*c++ != ' ')
+        return -1;
+    if (*c == '-')
+        c++;
+    else
+    {
+        int ep_rank = pos->turn_color == WHITE ? 5 : 2;
+        if (c[0] < 'a' || c[0] > 'h' || c[1] != '1' + ep_rank)
+            return -1;
+        int ep = SQUARE(c[0] - 'a', ep_rank);
+        if (chess_position_can_take_en_passant(pos, ep))
+            pos->en_passant = ep;
+        c += 2;
+    }
+    /* the clocks are optional */
+    if (c[0] == ' ' && c[1] >= '0' && c[1] <= '9')
+    {
+        c++;
+        pos->fifty_move_rule_turn_count = fen_read_number(&c);
+        if (*c++ != ' ')
+            return -1;
+        int full_moves = fen_read_number(&c);
+        if (full_moves < 0)
+            return -1;
+        pos->num_turns = full_moves > 0 ? full_moves - 1 : 0;
+    }
+    pos->key = chess_position_compute_key(pos);
+    return c - fen;
+}
+
+int chess_position_to_fen(ChessPosition *pos, char *buf)
+{
+    char *c = buf;
+    int x, y;
+    for (y = CHESS_BOARD_HEIGHT - 1; y >= 0; y--)
+    {
+        int empty = 0;
+        for (x = 0; x < CHESS_BOARD_WIDTH; x++)
+        {
+            int sq = SQUARE(x, y);
+            if (!pos->squares[sq])
+            {
+                empty++;
+                continue;
+            }
+            if (empty)
+                *c++ = '0' + empty;
+            empty = 0;
+            char p = FEN_PIECE_CHARS[POS_TYPE_AT(pos, sq)];
+            *c++ = POS_COLOR_AT(pos, sq) == WHITE ? p : p | 0x20;
+        }
+        if (empty)
+            *c++ = '0' + empty;
+        if (y)
+            *c++ = '/';
+    }
+    *c++ = ' ';
+    *c++ = pos->turn_color == WHITE ? 'w' : 'b';
+    *c++ = ' ';
+    if (!pos->castling)
+        *c++ = '-';
+    if (pos->castling & CASTLE_WHITE_KING)
+        *c++ = 'K';
+    if (pos->castling & CASTLE_WHITE_QUEEN)
+        *c++ = 'Q';
+    if (pos->castling & CASTLE_BLACK_KING)
+        *c++ = 'k';
+    if (pos->castling & CASTLE_BLACK_QUEEN)
+        *c++ = 'q';
+    *c++ = ' ';
+    if (pos->en_passant == NO_SQUARE)
+        *c++ = '-';
+    else
+    {
+        *c++ = 'a' + SQUARE_FILE(pos->en_passant);
+        *c++ = '1' + SQUARE_RANK(pos->en_passant);
+    }
+    c += sprintf(c, " %d %d", pos->fifty_move_rule_turn_count, pos->num_turns + 1);
+    return c - buf;
+}
+
+int chess_game_from_fen(ChessGame *game, const char *fen)
+{
+    ChessPosition pos;
+    int len = chess_position_from_fen(&pos, fen);
+    if (len < 0)
+        return -1;
+    memset(game, 0, sizeof(ChessGame));
+    chess_position_to_game(&pos, game);
+    return len;
+}
+
+int chess_game_to_fen(ChessGame *game, char *buf)
+{
+    ChessPosition pos;
+    chess_position_from_game(&pos, game);
+    return chess_position_to_fen(&pos, buf);
+}
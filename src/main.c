@@ -1,8 +1,45 @@
 #include "../include/chess.h"
+#include "../include/attacks.h"
+#include "../include/zobrist.h"
+#include "../include/syzygy.h"
+#include "../include/book.h"
+#include <string.h>
 #include <stdio.h>
 
-int main(void)
+/* ./a [-a <white | black>] [-b <Polyglot book>] [Syzygy tablebase directories]
+    -a has the AI play that color, it plays from the book while it can and its searches use the tablebases
+*/
+int main(int argc, char **argv)
 {
-    chess_game_start(NULL,0,BLACK);
+    PolyglotBook book = {0};
+    int enable_ai = 0;
+    ChessColor ai_color = BLACK;
+    chess_attacks_init();
+    chess_zobrist_init();
+    while (argc > 2 && argv[1][0] == '-')
+    {
+        if (strcmp(argv[1], "-a") == 0)
+        {
+            enable_ai = 1;
+            ai_color = argv[2][0] == 'w' || argv[2][0] == 'W' ? WHITE : BLACK;
+        }
+        else if (strcmp(argv[1], "-b") == 0 && !book.map)
+        {
+            if (polyglot_book_open(&book, argv[2]) < 0)
+                printf("Playing without the book '%s'.\n", argv[2]);
+        }
+        else
+            break;
+        argc -= 2;
+        argv += 2;
+    }
+    /* only the AI plays from the book */
+    if (book.map && !enable_ai)
+        printf("The book is only used by the AI, see -a.\n");
+    if (argc > 1 && syzygy_init(argv[1]) == 0)
+        printf("No tablebases in '%s'.\n", argv[1]);
+    chess_game_start(NULL,enable_ai,ai_color,book.map ? &book : NULL);
+    polyglot_book_close(&book);
+    syzygy_free();
     return 0;
 }
@@ -1,29 +1,28 @@
 #include "../include/move.h"
 #include "../include/common.h"
 
-void legal_move_add_next(LegalMove* dest, LegalMove add)
+void move_to_string(ChessMove m, char *buf)
 {
-        dest->next = (LegalMove*)malloc(sizeof(LegalMove));
-        *dest->next = add;
+        /* indexed by the promotion bits */
+        static const char promotion_chars[] = {'b', 'n', 'r', 'q'};
+        int from = MOVE_FROM(m), to = MOVE_TO(m);
+        buf[0] = (from & 7) + 'a';
+        buf[1] = (from >> 3) + '1';
+        buf[2] = (to & 7) + 'a';
+        buf[3] = (to >> 3) + '1';
+        buf[4] = 0;
+        if (MOVE_FLAGS(m) & MOVE_PROMOTION)
+        {
+                buf[4] = promotion_chars[MOVE_FLAGS(m) & 3];
+                buf[5] = 0;
+        }
 }
 
-void free_legal_move_array(LegalMoveArray *lma)
+int move_list_find(MoveList *list, ChessMove move)
 {
         int i;
-        for (i = 0; i < lma->len; i++)
-        {
-                if (lma->arr[i].next)
-                {
-                        LegalMove* node = lma->arr[i].next, *tmp = NULL;
-                        while (node)
-                        {
-                                tmp = node->next;
-                                free(node);
-                                node = tmp;
-                        }
-                }
-        }
-        lma->len = 0;
-        free(lma->arr);
-        free(lma);
-}
\ No newline at end of file
+        for (i = 0; i < list->len; i++)
+                if (list->moves[i] == move)
+                        return i;
+        return -1;
+}
@@ -0,0 +1,208 @@
+#include "../include/movegen.h"
+#include "../include/attacks.h"
+
+static inline Bitboard bb_shift(Bitboard b, int offset)
+{
+    return offset > 0 ? b << offset : b >> -offset;
+}
+
+/* targets are destination squares, the origin is to - offset */
+static void add_pawn_moves(MoveList *list, Bitboard targets, int offset, int flags, Bitboard promotion_rank)
+{
+    while (targets)
+    {
+        int to = bb_pop_lsb(&targets), from = to - offset;
+        if (BB_SQUARE(to) & promotion_rank)
+        {
+            int promotion_flags = (flags & MOVE_CAPTURE) | MOVE_PROMOTION;
+            MOVE_LIST_ADD(list, MOVE_ENCODE(from, to, promotion_flags | (QUEEN - BISHOP)));
+            MOVE_LIST_ADD(list, MOVE_ENCODE(from, to, promotion_flags | (KNIGHT - BISHOP)));
+            MOVE_LIST_ADD(list, MOVE_ENCODE(from, to, promotion_flags | (ROOK - BISHOP)));
+            MOVE_LIST_ADD(list, MOVE_ENCODE(from, to, promotion_flags | (BISHOP - BISHOP)));
+        }
+        else
+        {
+            MOVE_LIST_ADD(list, MOVE_ENCODE(from, to, flags));
+        }
+    }
+}
+
+/* only moves landing on target_mask are added, en passant is left to the caller */
+static void generate_pawn_moves(ChessPosition *pos, MoveList *list, Bitboard target_mask)
+{
+    ChessColor us = pos->turn_color;
+    Bitboard pawns = pos->pieces[us][PAWN], empty = ~pos->all, enemies = pos->occupied[!us];
+    int up = us == WHITE ? 8 : -8;
+    Bitboard promotion_rank = us == WHITE ? BB_RANK_8 : BB_RANK_1;
+    Bitboard double_push_rank = us == WHITE ? BB_RANK(3) : BB_RANK(4);
+
+    Bitboard single = bb_shift(pawns, up) & empty;
+    add_pawn_moves(list, single & target_mask, up, MOVE_QUIET, promotion_rank);
+    add_pawn_moves(list, bb_shift(single, up) & empty & double_push_rank & target_mask, 2 * up, MOVE_DOUBLE_PAWN_PUSH, 0);
+
+    /* captures towards the a and h files */
+    enemies &= target_mask;
+    add_pawn_moves(list, bb_shift(pawns & ~BB_FILE_A, up - 1) & enemies, up - 1, MOVE_CAPTURE, promotion_rank);
+    add_pawn_moves(list, bb_shift(pawns & ~BB_FILE_H, up + 1) & enemies, up + 1, MOVE_CAPTURE, promotion_rank);
+}
+
+static void add_piece_moves(ChessPosition *pos, MoveList *list, int from, Bitboard targets)
+{
+    Bitboard enemies = pos->occupied[!pos->turn_color];
+    targets &= ~pos->occupied[pos->turn_color];
+    while (targets)
+    {
+        int to = bb_pop_lsb(&targets);
+        MOVE_LIST_ADD(list, MOVE_ENCODE(from, to, (enemies & BB_SQUARE(to)) ? MOVE_CAPTURE : MOVE_QUIET));
+    }
+}
+
+/* knights, bishops, rooks and queens */
+static void generate_piece_moves(ChessPosition *pos, MoveList *list, Bitboard target_mask)
+{
+    ChessColor us = pos->turn_color;
+    Bitboard b;
+    for (b = pos->pieces[us][KNIGHT]; b;)
+    {
+        int from = bb_pop_lsb(&b);
+        add_piece_moves(pos, list, from, KNIGHT_ATTACKS[from] & target_mask);
+    }
+    for (b = pos->pieces[us][BISHOP]; b;)
+    {
+        int from = bb_pop_lsb(&b);
+        add_piece_moves(pos, list, from, bishop_attacks(from, pos->all) & target_mask);
+    }
+    for (b = pos->pieces[us][ROOK]; b;)
+    {
+        int from = bb_pop_lsb(&b);
+        add_piece_moves(pos, list, from, rook_attacks(from, pos->all) & target_mask);
+    }
+    for (b = pos->pieces[us][QUEEN]; b;)
+    {
+        int from = bb_pop_lsb(&b);
+        add_piece_moves(pos, list, from, queen_attacks(from, pos->all) & target_mask);
+    }
+}
+
+/* expects the king not to be in check */
+static void generate_castle_moves(ChessPosition *pos, MoveList *list)
+{
+    ChessColor us = pos->turn_color;
+    int king_side = us == WHITE ? CASTLE_WHITE_KING : CASTLE_BLACK_KING;
+    int queen_side = us == WHITE ? CASTLE_WHITE_QUEEN : CASTLE_BLACK_QUEEN;
+    int king = SQUARE(4, us == WHITE ? 0 : CHESS_BOARD_HEIGHT - 1);
+    if ((pos->castling & king_side) && !(pos->all & (BB_SQUARE(king + 1) | BB_SQUARE(king + 2))) &&
+        !chess_position_is_square_attacked(pos, king + 1, !us) && !chess_position_is_square_attacked(pos, king + 2, !us))
+        MOVE_LIST_ADD(list, MOVE_ENCODE(king, king + 2, MOVE_KING_CASTLE));
+    if ((pos->castling & queen_side) &&
+        !(pos->all & (BB_SQUARE(king - 1) | BB_SQUARE(king - 2) | BB_SQUARE(king - 3))) &&
+        !chess_position_is_square_attacked(pos, king - 1, !us) && !chess_position_is_square_attacked(pos, king - 2, !us))
+        MOVE_LIST_ADD(list, MOVE_ENCODE(king, king - 2, MOVE_QUEEN_CASTLE));
+}
+
+void chess_position_generate_moves(ChessPosition *pos, MoveList *list)
+{
+    ChessColor us = pos->turn_color;
+    int king = bb_lsb(pos->pieces[us][KING]);
+    list->len = 0;
+    generate_pawn_moves(pos, list, ~(Bitboard)0);
+    if (pos->en_passant != NO_SQUARE)
+    {
+        Bitboard takers = PAWN_ATTACKS[!us][pos->en_passant] & pos->pieces[us][PAWN];
+        while (takers)
+            MOVE_LIST_ADD(list, MOVE_ENCODE(bb_pop_lsb(&takers), pos->en_passant, MOVE_EN_PASSANT));
+    }
+    generate_piece_moves(pos, list, ~(Bitboard)0);
+    add_piece_moves(pos, list, king, KING_ATTACKS[king]);
+    if (!chess_position_is_square_attacked(pos, king, !us))
+        generate_castle_moves(pos, list);
+}
+
+void chess_position_generate_legal_moves(ChessPosition *pos, MoveList *list)
+{
+    ChessColor us = pos->turn_color, them = !us;
+    int king = bb_lsb(pos->pieces[us][KING]);
+    Bitboard enemy_bishops = pos->pieces[them][BISHOP] | pos->pieces[them][QUEEN];
+    Bitboard enemy_rooks = pos->pieces[them][ROOK] | pos->pieces[them][QUEEN];
+    Bitboard checkers = chess_position_attackers_to(pos, king, pos->all) & pos->occupied[them];
+    Bitboard b;
+    list->len = 0;
+
+    /* the king cannot hide behind itself from a slider, so it is taken off the board */
+    Bitboard without_king = pos->all ^ BB_SQUARE(king);
+    for (b = KING_ATTACKS[king] & ~pos->occupied[us]; b;)
+    {
+        int to = bb_pop_lsb(&b);
+        if (!(chess_position_attackers_to(pos, to, without_king) & pos->occupied[them]))
+            MOVE_LIST_ADD(list, MOVE_ENCODE(king, to, (pos->occupied[them] & BB_SQUARE(to)) ? MOVE_CAPTURE : MOVE_QUIET));
+    }
+    if (bb_popcount(checkers) > 1)
+        return;
+
+    /* in check the other pieces can only take the checker or block it */
+    Bitboard target_mask = ~(Bitboard)0;
+    if (checkers)
+        target_mask = checkers | BETWEEN_BB[king][bb_lsb(checkers)];
+
+    /* a piece is pinned when it is the only one between the king and an enemy slider */
+    Bitboard pinned = 0;
+    Bitboard snipers = (bishop_attacks(king, pos->occupied[them]) & enemy_bishops) |
+                       (rook_attacks(king, pos->occupied[them]) & enemy_rooks);
+    while (snipers)
+    {
+        Bitboard blockers = BETWEEN_BB[king][bb_pop_lsb(&snipers)] & pos->all;
+        if (bb_popcount(blockers) == 1)
+            pinned |= blockers & pos->occupied[us];
+    }
+
+    int first = list->len;
+    generate_pawn_moves(pos, list, target_mask);
+    generate_piece_moves(pos, list, target_mask);
+    if (pinned)
+    {
+        /* pinned pieces can only move along the line to the king */
+        int i, len = first;
+        for (i = first; i < list->len; i++)
+        {
+            ChessMove m = list->moves[i];
+            if (!(pinned & BB_SQUARE(MOVE_FROM(m))) || (LINE_BB[king][MOVE_FROM(m)] & BB_SQUARE(MOVE_TO(m))))
+                list->moves[len++] = m;
+        }
+        list->len = len;
+    }
+
+    if (pos->en_passant != NO_SQUARE)
+    {
+        /* two pawns leave the rank at once, so check the king with both of them gone */
+        int taken = pos->en_passant + (us == WHITE ? -CHESS_BOARD_WIDTH : CHESS_BOARD_WIDTH);
+        Bitboard takers = PAWN_ATTACKS[them][pos->en_passant] & pos->pieces[us][PAWN];
+        while (takers)
+        {
+            int from = bb_pop_lsb(&takers);
+            Bitboard occupied = (pos->all ^ BB_SQUARE(from) ^ BB_SQUARE(taken)) | BB_SQUARE(pos->en_passant);
+            /* a knight or pawn giving check can not be blocked */
+            if (!(bishop_attacks(king, occupied) & enemy_bishops) && !(rook_attacks(king, occupied) & enemy_rooks) &&
+                !(checkers & ~BB_SQUARE(taken) & (pos->pieces[them][KNIGHT] | pos->pieces[them][PAWN])))
+                MOVE_LIST_ADD(list, MOVE_ENCODE(from, pos->en_passant, MOVE_EN_PASSANT));
+        }
+    }
+
+    if (!checkers)
+        generate_castle_moves(pos, list);
+}
+
+int chess_position_in_check(ChessPosition *pos, ChessColor c)
+{
+    return chess_position_is_square_attacked(pos, bb_lsb(pos->pieces[c][KING]), !c);
+}
+
+int chess_position_is_valid(ChessPosition *pos)
+{
+    if (bb_popcount(pos->pieces[WHITE][KING]) != 1 || bb_popcount(pos->pieces[BLACK][KING]) != 1)
+        return 0;
+    /* pawns can't stand on the first or last rank, movegen would push them off the board */
+    if ((pos->pieces[WHITE][PAWN] | pos->pieces[BLACK][PAWN]) & (BB_RANK_1 | BB_RANK_8))
+        return 0;
+    /* the side that just moved can't have left its king in check */
+    return !chess_position_in_check(pos, !pos->turn_color);
+}
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <string.h>
+#include "../include/pack.h"
+#include "../include/zobrist.h"
+#include "../include/movegen.h"
+
+#define PACK_WHITE_TO_MOVE 1
+#define PACK_WHITE_WAS_CHECKED (1 << 5)
+#define PACK_BLACK_WAS_CHECKED (1 << 6)
+#define PACK_CASTLING_SHIFT 1
+
+static void pack_write_u64(unsigned char *b, uint64_t v)
+{
+    int i;
+    for (i = 0; i < 8; i++)
+        b[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint64_t pack_read_u64(const unsigned char *b)
+{
+    uint64_t v = 0;
+    int i;
+    for (i = 0; i < 8; i++)
+        v |= (uint64_t)b[i] << (8 * i);
+    return v;
+}
+
+static unsigned char pack_saturate(int n)
+{
+    return n < 0 ? 0 : n > 255 ? 255 : (unsigned char)n;
+}
+
+void chess_position_pack(ChessPosition *pos, ChessPackedPosition *packed)
+{
+    unsigned char *b = packed->bytes;
+    Bitboard pieces = pos->all;
+    int i = 0;
+    memset(b, 0, CHESS_PACKED_LEN);
+    pack_write_u64(b, pos->all);
+    /* a legal position has at most 32 pieces */
+    while (pieces && i < 32)
+    {
+        int sq = bb_pop_lsb(&pieces);
+        int code = POS_TYPE_AT(pos, sq) | (POS_COLOR_AT(pos, sq) == WHITE ? 8 : 0);
+        b[8 + i / 2] |= code << (4 * (i & 1));
+        i++;
+    }
+    b[24] = (pos->turn_color == WHITE ? PACK_WHITE_TO_MOVE : 0) | (pos->castling << PACK_CASTLING_SHIFT);
+    b[25] = pos->en_passant == NO_SQUARE ? 0 : SQUARE_FILE(pos->en_passant) + 1;
+    b[26] = pack_saturate(pos->fifty_move_rule_turn_count);
+    b[30] = pos->num_turns & 0xFF;
+    b[31] = (pos->num_turns >> 8) & 0xFF;
+}
+
+int chess_position_unpack(ChessPosition *pos, const ChessPackedPosition *packed)
+{
+    const unsigned char *b = packed->bytes;
+    Bitboard pieces = pack_read_u64(b);
+    int i = 0;
+    chess_position_clear(pos);
+    if (bb_popcount(pieces) > 32)
+        return -1;
+    while (pieces)
+    {
+        int sq = bb_pop_lsb(&pieces);
+        int code = (b[8 + i / 2] >> (4 * (i & 1))) & 15;
+        ChessPieceType type = code & 7;
+        if (type == NONE || type > KING)
+            return -1;
+        chess_position_put_piece(pos, sq, type, code & 8 ? WHITE : BLACK);
+        i++;
+    }
+    if (b[25] > 8)
+        return -1;
+    pos->turn_color = b[24] & PACK_WHITE_TO_MOVE ? WHITE : BLACK;
+    if (!chess_position_is_valid(pos))
+        return -1;
+    pos->castling = (b[24] >> PACK_CASTLING_SHIFT) & CASTLE_ALL;
+    chess_position_trim_castling(pos);
+    if (b[25])
+    {
+        int ep = SQUARE(b[25] - 1, pos->turn_color == WHITE ? 5 : 2);
+        if (chess_position_can_take_en_passant(pos, ep))
+            pos->en_passant = ep;
+    }
+    pos->fifty_move_rule_turn_count = b[26];
+    pos->num_turns = b[30] | (b[31] << 8);
+    pos->key = chess_position_compute_key(pos);
+    return 0;
+}
+
+void chess_game_pack(ChessGame *game, ChessPackedPosition *packed)
+{
+    ChessPosition pos;
+    chess_position_from_game(&pos, game);
+    chess_position_pack(&pos, packed);
+    if (game->data.king_was_checked.white)
+        packed->bytes[24] |= PACK_WHITE_WAS_CHECKED;
+    if (game->data.king_was_checked.black)
+        packed->bytes[24] |= PACK_BLACK_WAS_CHECKED;
+    packed->bytes[27] = pack_saturate(game->data.king_in_check.white);
+    packed->bytes[28] = pack_saturate(game->data.king_in_check.black);
+}
+
+int chess_game_unpack(ChessGame *game, const ChessPackedPosition *packed)
+{
+    ChessPosition pos;
+    if (chess_position_unpack(&pos, packed) < 0)
+        return -1;
+    memset(game, 0, sizeof(ChessGame));
+    chess_position_to_game(&pos, game);
+    game->data.king_was_checked.white = (packed->bytes[24] & PACK_WHITE_WAS_CHECKED) != 0;
+    game->data.king_was_checked.black = (packed->bytes[24] & PACK_BLACK_WAS_CHECKED) != 0;
+    game->data.king_in_check.white = packed->bytes[27];
+    game->data.king_in_check.black = packed->bytes[28];
+    return 0;
+}
+
+void chess_pack_write_header(unsigned char *header)
+{
+    memcpy(header, CHESS_PACK_MAGIC, 4);
+    header[4] = CHESS_PACK_VERSION & 0xFF;
+    header[5] = (CHESS_PACK_VERSION >> 8) & 0xFF;
+    header[6] = CHESS_PACKED_LEN & 0xFF;
+    header[7] = (CHESS_PACKED_LEN >> 8) & 0xFF;
+}
+
+int chess_pack_check_header(const unsigned char *header, const char *filename)
+{
+    int version = header[4] | (header[5] << 8), len = header[6] | (header[7] << 8);
+    if (memcmp(header, CHESS_PACK_MAGIC, 4) != 0)
+    {
+        fprintf(stderr, "'%s' is not a position file\n", filename);
+        return -1;
+    }
+    if (version != CHESS_PACK_VERSION || len != CHESS_PACKED_LEN)
+    {
+        fprintf(stderr, "'%s' is version %d with %d byte records, only version %d is supported\n", filename, version,
+                len, CHESS_PACK_VERSION);
+        return -1;
+    }
+    return 0;
+}
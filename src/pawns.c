@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/pawns.h"
+#include "../include/attacks.h"
+#include "../include/zobrist.h"
+
+/* middlegame and endgame penalties of each pawn with the weakness */
+#define PAWN_DOUBLED_MG 10
+#define PAWN_DOUBLED_EG 25
+#define PAWN_ISOLATED_MG 12
+#define PAWN_ISOLATED_EG 15
+#define PAWN_BACKWARD_MG 8
+#define PAWN_BACKWARD_EG 12
+/* middlegame bonus for each pawn in the two ranks in front of the king, on its file or the files beside it */
+#define PAWN_SHIELD_MG 10
+
+const int PAWN_PASSED_MG[CHESS_BOARD_HEIGHT] = {0, 0, 5, 10, 20, 35, 60, 0};
+const int PAWN_PASSED_EG[CHESS_BOARD_HEIGHT] = {0, 10, 15, 25, 45, 75, 120, 0};
+
+/* the files either side of file x */
+static Bitboard pawn_adjacent_files(int x)
+{
+    return (x > 0 ? BB_FILE(x - 1) : 0) | (x < CHESS_BOARD_WIDTH - 1 ? BB_FILE(x + 1) : 0);
+}
+
+/* the ranks in front of rank y for color, y may be off the board */
+static Bitboard pawn_ranks_ahead(ChessColor color, int y)
+{
+    if (color == WHITE)
+        return y >= CHESS_BOARD_HEIGHT - 1 ? 0 : ~0ULL << (8 * (y < 0 ? 0 : y + 1));
+    return y <= 0 ? 0 : y >= CHESS_BOARD_HEIGHT ? ~0ULL : (1ULL << (8 * y)) - 1;
+}
+
+/* the structure of one side, added to entry as positive for white */
+static void pawn_evaluate_side(ChessPosition *pos, ChessColor us, PawnEntry *entry)
+{
+    Bitboard ours = pos->pieces[us][PAWN], theirs = pos->pieces[!us][PAWN], pawns = ours;
+    int mg = 0, eg = 0, x;
+    for (x = 0; x < CHESS_BOARD_WIDTH; x++)
+    {
+        int on_file = bb_popcount(ours & BB_FILE(x));
+        if (on_file > 1)
+        {
+            mg -= PAWN_DOUBLED_MG * (on_file - 1);
+            eg -= PAWN_DOUBLED_EG * (on_file - 1);
+        }
+    }
+    entry->passed[us] = 0;
+    while (pawns)
+    {
+        int sq = bb_pop_lsb(&pawns), x = SQUARE_FILE(sq), y = SQUARE_RANK(sq);
+        int stop = us == WHITE ? sq + CHESS_BOARD_WIDTH : sq - CHESS_BOARD_WIDTH;
+        Bitboard beside = pawn_adjacent_files(x), ahead = pawn_ranks_ahead(us, y);
+        if (!(theirs & (beside | BB_FILE(x)) & ahead))
+        {
+            int relative_rank = us == WHITE ? y : CHESS_BOARD_HEIGHT - 1 - y;
+            entry->passed[us] |= BB_SQUARE(sq);
+            mg += PAWN_PASSED_MG[relative_rank];
+            eg += PAWN_PASSED_EG[relative_rank];
+        }
+        if (!(ours & beside))
+        {
+            mg -= PAWN_ISOLATED_MG;
+            eg -= PAWN_ISOLATED_EG;
+        }
+        /* no pawn beside or behind it can defend its way forward, and an enemy pawn guards it */
+        else if (!(ours & beside & ~ahead) && (PAWN_ATTACKS[us][stop] & theirs))
+        {
+            mg -= PAWN_BACKWARD_MG;
+            eg -= PAWN_BACKWARD_EG;
+        }
+    }
+    entry->mg += us == WHITE ? mg : -mg;
+    entry->eg += us == WHITE ? eg : -eg;
+}
+
+void chess_position_evaluate_pawns(ChessPosition *pos, PawnEntry *entry)
+{
+    entry->key = pos->pawn_key;
+    entry->mg = 0;
+    entry->eg = 0;
+    pawn_evaluate_side(pos, WHITE, entry);
+    pawn_evaluate_side(pos, BLACK, entry);
+}
+
+/* the king shield and blocked passed pawns of one side, positive for white */
+static void pawn_score_side(PawnEntry *entry, ChessPosition *pos, ChessColor us, int *mg, int *eg)
+{
+    Bitboard passed = entry->passed[us], king = pos->pieces[us][KING];
+    int shield = 0, blocked = 0;
+    if (king)
+    {
+        int sq = bb_lsb(king), x = SQUARE_FILE(sq), y = SQUARE_RANK(sq);
+        Bitboard front = pawn_ranks_ahead(us, y) & ~pawn_ranks_ahead(us, us == WHITE ? y + 2 : y - 2);
+        shield = PAWN_SHIELD_MG * bb_popcount(pos->pieces[us][PAWN] & (BB_FILE(x) | pawn_adjacent_files(x)) & front);
+    }
+    /* a passed pawn with a piece in its way is worth half as much in the endgame */
+    while (passed)
+    {
+        int sq = bb_pop_lsb(&passed), stop = us == WHITE ? sq + CHESS_BOARD_WIDTH : sq - CHESS_BOARD_WIDTH;
+        if (pos->all & BB_SQUARE(stop))
+            blocked += PAWN_PASSED_EG[us == WHITE ? SQUARE_RANK(sq) : CHESS_BOARD_HEIGHT - 1 - SQUARE_RANK(sq)] / 2;
+    }
+    *mg += us == WHITE ? shield : -shield;
+    *eg -= us == WHITE ? blocked : -blocked;
+}
+
+void pawn_entry_score(PawnEntry *entry, ChessPosition *pos, int *mg, int *eg)
+{
+    *mg = entry->mg;
+    *eg = entry->eg;
+    pawn_score_side(entry, pos, WHITE, mg, eg);
+    pawn_score_side(entry, pos, BLACK, mg, eg);
+}
+
+void pawn_table_clear(PawnTable *table)
+{
+    memset(table, 0, sizeof(PawnTable));
+}
+
+void pawn_tables_init(PawnTables *pawns)
+{
+    pawns->tables = NULL;
+    pawns->len = 0;
+}
+
+void pawn_tables_reserve(PawnTables *pawns, int len)
+{
+    PawnTable *tables;
+    if (len <= pawns->len)
+        return;
+    tables = realloc(pawns->tables, sizeof(PawnTable) * len);
+    if (!tables)
+    {
+        perror("Failed to allocate pawn tables");
+        exit(1);
+    }
+    memset(tables + pawns->len, 0, sizeof(PawnTable) * (len - pawns->len));
+    pawns->tables = tables;
+    pawns->len = len;
+}
+
+void pawn_tables_free(PawnTables *pawns)
+{
+    free(pawns->tables);
+    pawn_tables_init(pawns);
+}
+
+PawnEntry *pawn_table_probe(PawnTable *table, ChessPosition *pos)
+{
+    PawnEntry *entry = &table->entries[pos->pawn_key & (PAWN_TABLE_LEN - 1)];
+    /* an empty entry has key 0, which is also the key with no pawns and the right entry for it */
+    if (entry->key != pos->pawn_key)
+        chess_position_evaluate_pawns(pos, entry);
+    return entry;
+}
+
+uint64_t chess_position_compute_pawn_key(ChessPosition *pos)
+{
+    uint64_t key = 0;
+    ChessColor c;
+    for (c = BLACK; c <= WHITE; c++)
+    {
+        Bitboard pawns = pos->pieces[c][PAWN];
+        while (pawns)
+            key ^= ZOBRIST_PIECES[c][PAWN][bb_pop_lsb(&pawns)];
+    }
+    return key;
+}
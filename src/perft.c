@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "../include/perft.h"
+#include "../include/movegen.h"
+#include "../include/fen.h"
+
+/* the standard positions from the Chess Programming Wiki */
+static const PerftReference PERFT_REFERENCES[] = {
+    {"startpos", FEN_START, 6, {20ULL, 400ULL, 8902ULL, 197281ULL, 4865609ULL, 119060324ULL}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5,
+     {48ULL, 2039ULL, 97862ULL, 4085603ULL, 193690690ULL}},
+    {"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6,
+     {14ULL, 191ULL, 2812ULL, 43238ULL, 674624ULL, 11030083ULL}},
+    {"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5,
+     {6ULL, 264ULL, 9467ULL, 422333ULL, 15833292ULL}},
+    {"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5,
+     {44ULL, 1486ULL, 62379ULL, 2103487ULL, 89941194ULL}},
+    {"position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 5,
+     {46ULL, 2079ULL, 89890ULL, 3894594ULL, 164075551ULL}},
+};
+
+#define PERFT_REFERENCES_LEN (sizeof(PERFT_REFERENCES) / sizeof(PERFT_REFERENCES[0]))
+
+static unsigned long long perft_recurse(ChessPosition *pos, int depth)
+{
+    MoveList list;
+    ChessUndo undo;
+    unsigned long long nodes = 0;
+    int i;
+    chess_position_generate_legal_moves(pos, &list);
+    /* every move is legal, so the last ply is just counted */
+    if (depth <= 1)
+        return list.len;
+    for (i = 0; i < list.len; i++)
+    {
+        chess_position_make_move(pos, list.moves[i], &undo);
+        nodes += perft_recurse(pos, depth - 1);
+        chess_position_unmake_move(pos, &undo);
+    }
+    return nodes;
+}
+
+unsigned long long chess_position_perft(ChessPosition *pos, int depth)
+{
+    if (depth <= 0)
+        return 1;
+    return perft_recurse(pos, depth);
+}
+
+void perft_table_init(PerftTable *table, size_t mb)
+{
+    size_t bytes = mb * 1024 * 1024, entries = 1;
+    while (entries * 2 * sizeof(PerftEntry) <= bytes)
+        entries *= 2;
+    table->entries = calloc(entries, sizeof(PerftEntry));
+    if (!table->entries)
+    {
+        perror("Failed to allocate perft table");
+        exit(1);
+    }
+    table->mask = entries - 1;
+}
+
+void perft_table_free(PerftTable *table)
+{
+    free(table->entries);
+    memset(table, 0, sizeof(PerftTable));
+}
+
+static unsigned long long perft_recurse_hashed(ChessPosition *pos, int depth, PerftTable *table)
+{
+    MoveList list;
+    ChessUndo undo;
+    unsigned long long nodes = 0;
+    int i;
+    /* the last ply is cheaper to count than to look up */
+    if (depth <= 1)
+        return depth <= 0 ? 1 : perft_recurse(pos, depth);
+    volatile PerftEntry *entry = &table->entries[pos->key & table->mask];
+    uint64_t data = entry->data;
+    if ((entry->key ^ data) == pos->key && (int)(data & 0xFF) == depth)
+        return data >> 8;
+    chess_position_generate_legal_moves(pos, &list);
+    for (i = 0; i < list.len; i++)
+    {
+        chess_position_make_move(pos, list.moves[i], &undo);
+        nodes += perft_recurse_hashed(pos, depth - 1, table);
+        chess_position_unmake_move(pos, &undo);
+    }
+    data = (nodes << 8) | (uint64_t)depth;
+    entry->key = pos->key ^ data;
+    entry->data = data;
+    return nodes;
+}
+
+/* one or two moves from the root to count below */
+typedef struct
+{
+    int root;
+    ChessMove moves[2];
+    int len;
+    unsigned long long nodes;
+} PerftJob;
+
+typedef struct
+{
+    ChessPosition *pos;
+    int depth;
+    PerftTable *table;
+    PerftJob *jobs;
+    int jobs_len;
+    /* next job to hand out */
+    int next;
+    pthread_mutex_t lock;
+} PerftWork;
+
+static void *perft_worker(void *arg)
+{
+    PerftWork *work = (PerftWork *)arg;
+    while (1)
+    {
+        pthread_mutex_lock(&work->lock);
+        int i = work->next++;
+        pthread_mutex_unlock(&work->lock);
+        if (i >= work->jobs_len)
+            break;
+        PerftJob *job = &work->jobs[i];
+        ChessPosition pos = *work->pos;
+        ChessUndo undo;
+        int j, depth = work->depth - job->len;
+        for (j = 0; j < job->len; j++)
+            chess_position_make_move(&pos, job->moves[j], &undo);
+        job->nodes = work->table ? perft_recurse_hashed(&pos, depth, work->table) : chess_position_perft(&pos, depth);
+    }
+    return NULL;
+}
+
+unsigned long long chess_position_perft_parallel(ChessPosition *pos, int depth, const PerftOptions *options,
+                                                 unsigned long long *move_nodes)
+{
+    MoveList root, children;
+    ChessUndo undo;
+    PerftWork work;
+    pthread_t *handles;
+    unsigned long long total = 0;
+    int i, j, threads = options->threads > 0 ? options->threads : get_cpu_count();
+    if (depth <= 0)
+        return 1;
+    chess_position_generate_legal_moves(pos, &root);
+    /* at least as many jobs as root moves, the second ply gives enough to keep many threads busy */
+    work.jobs = malloc(sizeof(PerftJob) * root.len * (depth >= 3 ? MOVE_LIST_CAPACITY : 1));
+    handles = malloc(sizeof(pthread_t) * threads);
+    if (!work.jobs || !handles)
+    {
+        perror("Failed to allocate perft jobs");
+        exit(1);
+    }
+    work.jobs_len = 0;
+    for (i = 0; i < root.len; i++)
+    {
+        if (depth < 3)
+        {
+            work.jobs[work.jobs_len++] = (PerftJob){i, {root.moves[i], MOVE_NONE}, 1, 0};
+            continue;
+        }
+        chess_position_make_move(pos, root.moves[i], &undo);
+        chess_position_generate_legal_moves(pos, &children);
+        chess_position_unmake_move(pos, &undo);
+        for (j = 0; j < children.len; j++)
+            work.jobs[work.jobs_len++] = (PerftJob){i, {root.moves[i], children.moves[j]}, 2, 0};
+    }
+    work.pos = pos;
+    work.depth = depth;
+    work.table = options->table;
+    work.next = 0;
+    pthread_mutex_init(&work.lock, NULL);
+    for (i = 1; i < threads; i++)
+    {
+        if (pthread_create(&handles[i], NULL, perft_worker, &work) != 0)
+        {
+            perror("Failed to start perft thread");
+            exit(1);
+        }
+    }
+    perft_worker(&work);
+    for (i = 1; i < threads; i++)
+        pthread_join(handles[i], NULL);
+    pthread_mutex_destroy(&work.lock);
+    if (move_nodes)
+        memset(move_nodes, 0, sizeof(unsigned long long) * root.len);
+    for (i = 0; i < work.jobs_len; i++)
+    {
+        total += work.jobs[i].nodes;
+        if (move_nodes)
+            move_nodes[work.jobs[i].root] += work.jobs[i].nodes;
+    }
+    free(work.jobs);
+    free(handles);
+    return total;
+}
+
+unsigned long long chess_game_perft(ChessGame *game, int depth)
+{
+    ChessPosition pos;
+    chess_position_from_game(&pos, game);
+    return chess_position_perft(&pos, depth);
+}
+
+unsigned long long chess_game_perft_divide(ChessGame *game, int depth, const PerftOptions *options)
+{
+    if (depth <= 0)
+        return 1;
+    double start = get_time();
+    ChessPosition pos;
+    MoveList list;
+    unsigned long long move_nodes[MOVE_LIST_CAPACITY];
+    unsigned long long total;
+    int i;
+    chess_position_from_game(&pos, game);
+    chess_position_generate_legal_moves(&pos, &list);
+    total = chess_position_perft_parallel(&pos, depth, options, move_nodes);
+    for (i = 0; i < list.len; i++)
+    {
+        char name[6];
+        move_to_string(list.moves[i], name);
+        printf("%s: %llu\n", name, move_nodes[i]);
+    }
+    double elapsed = get_time() - start;
+    printf("\nNodes searched: %llu\n", total);
+    printf("Time: %.3fs, %.0f nodes/sec\n", elapsed, elapsed > 0 ? total / elapsed : 0.0);
+    return total;
+}
+
+int perft_run_reference_suite(int max_depth, const PerftOptions *options)
+{
+    int failed = 0;
+    unsigned long long all_nodes = 0;
+    double suite_start = get_time();
+    size_t i;
+    for (i = 0; i < PERFT_REFERENCES_LEN; i++)
+    {
+        const PerftReference *ref = &PERFT_REFERENCES[i];
+        ChessPosition pos;
+        if (chess_position_from_fen(&pos, ref->fen) < 0)
+        {
+            fprintf(stderr, "Bad FEN for %s\n", ref->name);
+            failed++;
+            continue;
+        }
+        int depth, last = ref->max_depth < max_depth ? ref->max_depth : max_depth;
+        printf("%s\n", ref->name);
+        for (depth = 1; depth <= last; depth++)
+        {
+            double start = get_time();
+            unsigned long long nodes = chess_position_perft_parallel(&pos, depth, options, NULL);
+            double elapsed = get_time() - start;
+            int ok = nodes == ref->nodes[depth - 1];
+            if (!ok)
+                failed++;
+            all_nodes += nodes;
+            printf("  depth %2d: %12llu %s expected %12llu %8.3fs %12.0f nodes/sec\n", depth, nodes, ok ? "ok  " : "FAIL",
+                   ref->nodes[depth - 1], elapsed, elapsed > 0 ? nodes / elapsed : 0.0);
+        }
+    }
+    double elapsed = get_time() - suite_start;
+    printf("Total: %llu nodes in %.3fs, %.0f nodes/sec, %d failed\n", all_nodes, elapsed,
+           elapsed > 0 ? all_nodes / elapsed : 0.0, failed);
+    return failed;
+}
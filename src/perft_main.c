@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <string.h>
+#include "../include/perft.h"
+#include "../include/attacks.h"
+#include "../include/zobrist.h"
+#include "../include/fen.h"
+
+static void usage(const char *exe)
+{
+    printf("usage: %s [options]                  run the reference positions\n", exe);
+    printf("       %s [options] suite <depth>    run the reference positions up to depth\n", exe);
+    printf("       %s [options] <depth> [file]   divide from the start position or a saved game\n", exe);
+    printf("options:\n");
+    printf("       -t <threads>    threads to count with, default one per core\n");
+    printf("       -H <mb>         count transposed subtrees once using a table of mb megabytes\n");
+    printf("       -f <fen>        divide from this position\n");
+}
+
+int main(int argc, char **argv)
+{
+    PerftOptions options = {0, NULL};
+    PerftTable table;
+    const char *exe = argv[0], *fen = NULL;
+    int ret = 0;
+    chess_attacks_init();
+    chess_zobrist_init();
+    /* options come first */
+    while (argc > 2 && argv[1][0] == '-')
+    {
+        if (strcmp(argv[1], "-t") == 0)
+            options.threads = atoi(argv[2]);
+        else if (strcmp(argv[1], "-f") == 0)
+            fen = argv[2];
+        else if (strcmp(argv[1], "-H") == 0 && !options.table && atoi(argv[2]) > 0)
+        {
+            perft_table_init(&table, atoi(argv[2]));
+            options.table = &table;
+        }
+        else
+        {
+            usage(exe);
+            return 1;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc < 2)
+        ret = perft_run_reference_suite(PERFT_MAX_DEPTH, &options) ? 1 : 0;
+    else if (strcmp(argv[1], "suite") == 0)
+        ret = perft_run_reference_suite(argc > 2 ? atoi(argv[2]) : PERFT_MAX_DEPTH, &options) ? 1 : 0;
+    else
+    {
+        int depth = atoi(argv[1]);
+        if (depth <= 0)
+        {
+            usage(exe);
+            ret = 1;
+        }
+        else
+        {
+            ChessGame game = {0};
+            chess_board_init(game.board);
+            game.data.turn_color = WHITE;
+            if (argc > 2)
+                chess_game_deserialize(&game, argv[2]);
+            if (fen && chess_game_from_fen(&game, fen) < 0)
+            {
+                fprintf(stderr, "Invalid FEN '%s'\n", fen);
+                ret = 1;
+            }
+            else
+                chess_game_perft_divide(&game, depth, &options);
+        }
+    }
+    if (options.table)
+        perft_table_free(&table);
+    return ret;
+}
@@ -0,0 +1,253 @@
+#include <ctype.h>
+#include <string.h>
+#include "../include/pgn.h"
+#include "../include/fen.h"
+#include "../include/san.h"
+#include "../include/movegen.h"
+
+static int pgn_getc(PgnReader *r)
+{
+    int c;
+    if (r->pushback != EOF)
+    {
+        c = r->pushback;
+        r->pushback = EOF;
+        r->offset++;
+        return c;
+    }
+    if (r->chunk_pos == r->chunk_len)
+    {
+        r->chunk_len = fread(r->chunk, 1, PGN_CHUNK_LEN, r->f);
+        r->chunk_pos = 0;
+        if (r->chunk_len == 0)
+            return EOF;
+    }
+    r->offset++;
+    return (unsigned char)r->chunk[r->chunk_pos++];
+}
+
+static void pgn_ungetc(PgnReader *r, int c)
+{
+    if (c == EOF)
+        return;
+    r->pushback = c;
+    r->offset--;
+}
+
+static void pgn_seek(PgnReader *r, long offset)
+{
+    fseek(r->f, offset, SEEK_SET);
+    r->offset = offset;
+    r->chunk_len = r->chunk_pos = 0;
+    r->pushback = EOF;
+}
+
+/* moves to the start of the first line that begins with "[Event " */
+static void pgn_skip_to_game(PgnReader *r)
+{
+    static const char event[] = "[Event ";
+    int c, i;
+    /* whether r->offset starts a line depends on the char before it */
+    pgn_seek(r, r->offset - 1);
+    c = pgn_getc(r);
+    while (c != EOF)
+    {
+        if (c != '\n')
+        {
+            c = pgn_getc(r);
+            continue;
+        }
+        long line = r->offset;
+        for (i = 0; event[i] && (c = pgn_getc(r)) == event[i]; i++)
+            ;
+        if (!event[i])
+        {
+            pgn_seek(r, line);
+            return;
+        }
+    }
+}
+
+int pgn_reader_open(PgnReader *reader, const char *filename, long start, long end)
+{
+    reader->f = fopen(filename, "rb");
+    if (!reader->f)
+    {
+        fprintf(stderr, "Failed to open file '%s'\n", filename);
+        return -1;
+    }
+    reader->end = end;
+    pgn_seek(reader, start);
+    if (start > 0)
+        pgn_skip_to_game(reader);
+    return 0;
+}
+
+void pgn_reader_close(PgnReader *reader)
+{
+    fclose(reader->f);
+    reader->f = NULL;
+}
+
+/* reads chars until stop or the end of the line, returns the number kept in buf */
+static size_t pgn_read_until(PgnReader *r, char *buf, char stop)
+{
+    size_t len = 0;
+    int c;
+    while ((c = pgn_getc(r)) != EOF && c != stop && c != '\n')
+    {
+        if (c == '\\' && stop == '"')
+            c = pgn_getc(r);
+        if (buf && len < PGN_TOKEN_LEN - 1)
+            buf[len++] = (char)c;
+    }
+    if (buf)
+        buf[len] = 0;
+    return len;
+}
+
+/* [Name "value"] after the [ */
+static void pgn_read_tag(PgnReader *r, PgnGame *game)
+{
+    char name[PGN_TOKEN_LEN];
+    size_t len = 0;
+    int c;
+    while ((c = pgn_getc(r)) != EOF && !isspace(c) && c != '"' && c != ']')
+        if (len < PGN_TOKEN_LEN - 1)
+            name[len++] = (char)c;
+    name[len] = 0;
+    while (c != EOF && c != '"' && c != ']' && c != '\n')
+        c = pgn_getc(r);
+    if (c == '"')
+    {
+        char *value = strcmp(name, "White") == 0    ? game->white
+                      : strcmp(name, "Black") == 0  ? game->black
+                      : strcmp(name, "Result") == 0 ? game->result
+                      : strcmp(name, "FEN") == 0    ? game->fen
+                                                    : NULL;
+        pgn_read_until(r, value, '"');
+        pgn_read_until(r, NULL, ']');
+    }
+}
+
+/* skips a comment or variation, which can nest */
+static void pgn_skip_block(PgnReader *r, char open)
+{
+    int c, depth = 1;
+    char close = open == '{' ? '}' : ')';
+    while (depth > 0 && (c = pgn_getc(r)) != EOF)
+    {
+        if (c == '{' && open == '(')
+            pgn_skip_block(r, '{');
+        else if (c == open)
+            depth++;
+        else if (c == close)
+            depth--;
+    }
+}
+
+static int pgn_is_result(const char *token)
+{
+    return strcmp(token, "1-0") == 0 || strcmp(token, "0-1") == 0 || strcmp(token, "1/2-1/2") == 0 ||
+           strcmp(token, "*") == 0;
+}
+
+static void pgn_play_token(PgnGame *game, const char *token, PgnMoveFn on_move, void *arg)
+{
+    MoveList legal;
+    ChessMove move;
+    ChessUndo undo;
+    /* move numbers, "12." "12..." or glued on as "12.e4". The digits are only a number when a '.' follows,
+        so the 0 of 0-0 is kept
+    */
+    const char *c = token;
+    while (isdigit((unsigned char)*c))
+        c++;
+    if (c != token && *c == '.')
+    {
+        while (*c == '.')
+            c++;
+        token = c;
+    }
+    if (!*token || game->error[0])
+        return;
+    chess_position_generate_legal_moves(&game->pos, &legal);
+    if (chess_position_parse_san(&game->pos, &legal, token, &move) != SAN_OK)
+    {
+        snprintf(game->error, PGN_TOKEN_LEN, "%s", token);
+        return;
+    }
+    if (on_move)
+        on_move(game, move, arg);
+    chess_position_make_move(&game->pos, move, &undo);
+    game->plies++;
+}
+
+int pgn_read_game(PgnReader *r, PgnGame *game, PgnMoveFn on_move, void *arg)
+{
+    char token[PGN_TOKEN_LEN];
+    int c, started = 0, in_moves = 0;
+    memset(game, 0, sizeof(PgnGame));
+    while ((c = pgn_getc(r)) != EOF)
+    {
+        if (isspace(c))
+            continue;
+        if (!started)
+        {
+            if (r->end >= 0 && r->offset - 1 >= r->end)
+                return 0;
+            started = 1;
+        }
+        if (c == '[')
+        {
+            /* the next game's tags, this one had no result */
+            if (in_moves)
+            {
+                pgn_ungetc(r, c);
+                break;
+            }
+            pgn_read_tag(r, game);
+            continue;
+        }
+        if (!in_moves)
+        {
+            in_moves = 1;
+            if (!game->fen[0] || chess_position_from_fen(&game->pos, game->fen) < 0)
+            {
+                if (game->fen[0])
+                    strcpy(game->error, "FEN");
+                chess_position_from_fen(&game->pos, FEN_START);
+            }
+        }
+        if (c == '{' || c == '(')
+        {
+            pgn_skip_block(r, (char)c);
+            continue;
+        }
+        if (c == ';' || c == '%')
+        {
+            pgn_read_until(r, NULL, '\n');
+            continue;
+        }
+        size_t len = 0;
+        while (c != EOF && !isspace(c) && !strchr("{}();[", c))
+        {
+            if (len < PGN_TOKEN_LEN - 1)
+                token[len++] = (char)c;
+            c = pgn_getc(r);
+        }
+        pgn_ungetc(r, c);
+        token[len] = 0;
+        /* annotation glyphs */
+        if (token[0] == '$')
+            continue;
+        if (pgn_is_result(token))
+        {
+            if (!game->result[0])
+                strcpy(game->result, token);
+            break;
+        }
+        pgn_play_token(game, token, on_move, arg);
+    }
+    return started;
+}
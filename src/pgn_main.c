@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "../include/pgn.h"
+#include "../include/attacks.h"
+#include "../include/zobrist.h"
+
+/* errors printed by each thread, the rest are only counted */
+#define PGN_MAX_REPORTED_ERRORS 5
+
+typedef struct
+{
+    const char *filename;
+    long start, end;
+    unsigned long long games, plies, errors;
+    int failed;
+} PgnJob;
+
+static void usage(const char *exe)
+{
+    printf("usage: %s [-t <threads>] <file.pgn>    replay every game and report games/sec\n", exe);
+}
+
+static void *pgn_replay(void *arg)
+{
+    PgnJob *job = (PgnJob *)arg;
+    PgnReader *reader = malloc(sizeof(PgnReader));
+    PgnGame game;
+    if (!reader)
+    {
+        perror("Failed to allocate PGN reader");
+        exit(1);
+    }
+    if (pgn_reader_open(reader, job->filename, job->start, job->end) < 0)
+    {
+        job->failed = 1;
+        free(reader);
+        return NULL;
+    }
+    while (pgn_read_game(reader, &game, NULL, NULL))
+    {
+        job->games++;
+        job->plies += game.plies;
+        if (game.error[0] && job->errors++ < PGN_MAX_REPORTED_ERRORS)
+            fprintf(stderr, "%s - %s: could not play '%s' after %d plies\n", game.white, game.black, game.error,
+                    game.plies);
+    }
+    pgn_reader_close(reader);
+    free(reader);
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    int threads = 0, i;
+    const char *filename;
+    chess_attacks_init();
+    chess_zobrist_init();
+    if (argc == 4 && strcmp(argv[1], "-t") == 0)
+    {
+        threads = atoi(argv[2]);
+        filename = argv[3];
+    }
+    else if (argc == 2)
+        filename = argv[1];
+    else
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    if (threads <= 0)
+        threads = get_cpu_count();
+    FILE *f = fopen(filename, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "Failed to open file '%s'\n", filename);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+
+    PgnJob *jobs = calloc(threads, sizeof(PgnJob));
+    pthread_t *handles = malloc(sizeof(pthread_t) * threads);
+    if (!jobs || !handles)
+    {
+        perror("Failed to allocate PGN jobs");
+        exit(1);
+    }
+    double start = get_time();
+    /* each thread takes an even share of the bytes, the readers find the game boundaries */
+    for (i = 0; i < threads; i++)
+    {
+        jobs[i].filename = filename;
+        jobs[i].start = size / threads * i;
+        jobs[i].end = i == threads - 1 ? -1 : size / threads * (i + 1);
+        if (i > 0 && pthread_create(&handles[i], NULL, pgn_replay, &jobs[i]) != 0)
+        {
+            perror("Failed to start PGN thread");
+            exit(1);
+        }
+    }
+    pgn_replay(&jobs[0]);
+    for (i = 1; i < threads; i++)
+        pthread_join(handles[i], NULL);
+    double elapsed = get_time() - start;
+
+    unsigned long long games = 0, plies = 0, errors = 0;
+    int failed = 0;
+    for (i = 0; i < threads; i++)
+    {
+        games += jobs[i].games;
+        plies += jobs[i].plies;
+        errors += jobs[i].errors;
+        failed |= jobs[i].failed;
+    }
+    printf("%llu games, %llu plies, %llu games with moves that could not be played\n", games, plies, errors);
+    printf("Time: %.3fs, %.0f games/sec, %.0f plies/sec\n", elapsed, elapsed > 0 ? games / elapsed : 0.0,
+           elapsed > 0 ? plies / elapsed : 0.0);
+    free(jobs);
+    free(handles);
+    return failed || errors ? 1 : 0;
+}
@@ -0,0 +1,152 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+#include "../include/posdb.h"
+
+/* maps filename read only, returns the start or NULL */
+static const unsigned char *position_database_map(PositionDatabase *db, const char *filename)
+{
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    db->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (db->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(db->file, &size) || size.QuadPart == 0)
+        return NULL;
+    db->map_len = (size_t)size.QuadPart;
+    db->mapping = CreateFileMappingA(db->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!db->mapping)
+        return NULL;
+    return (const unsigned char *)MapViewOfFile(db->mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+    struct stat st;
+    void *map;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    if (fstat(fd, &st) < 0 || st.st_size == 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    db->map_len = (size_t)st.st_size;
+    map = mmap(NULL, db->map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    /* the mapping keeps the file open */
+    close(fd);
+    if (map == MAP_FAILED)
+        return NULL;
+    posix_madvise(map, db->map_len, POSIX_MADV_SEQUENTIAL);
+    return (const unsigned char *)map;
+#endif
+}
+
+int position_database_open(PositionDatabase *db, const char *filename)
+{
+    memset(db, 0, sizeof(PositionDatabase));
+    db->map = position_database_map(db, filename);
+    if (!db->map)
+    {
+        fprintf(stderr, "Failed to map file '%s'\n", filename);
+        position_database_close(db);
+        return -1;
+    }
+    if (db->map_len < CHESS_PACK_HEADER_LEN || chess_pack_check_header(db->map, filename) < 0)
+    {
+        if (db->map_len < CHESS_PACK_HEADER_LEN)
+            fprintf(stderr, "'%s' is too short to be a position file\n", filename);
+        position_database_close(db);
+        return -1;
+    }
+    db->records = (const ChessPackedPosition *)(db->map + CHESS_PACK_HEADER_LEN);
+    db->len = (db->map_len - CHESS_PACK_HEADER_LEN) / CHESS_PACKED_LEN;
+    return 0;
+}
+
+void position_database_close(PositionDatabase *db)
+{
+#ifdef _WIN32
+    if (db->map)
+        UnmapViewOfFile(db->map);
+    if (db->mapping)
+        CloseHandle(db->mapping);
+    if (db->file && db->file != INVALID_HANDLE_VALUE)
+        CloseHandle(db->file);
+#else
+    if (db->map)
+        munmap((void *)db->map, db->map_len);
+#endif
+    memset(db, 0, sizeof(PositionDatabase));
+}
+
+size_t position_database_next_batch(PositionDatabase *db, size_t *cursor, ChessPosition *batch, size_t batch_len)
+{
+    size_t filled = 0;
+    while (filled < batch_len && *cursor < db->len)
+    {
+        if (chess_position_unpack(&batch[filled], &db->records[*cursor]) == 0)
+            filled++;
+        (*cursor)++;
+    }
+    return filled;
+}
+
+size_t position_database_stream(PositionDatabase *db, size_t batch_len, PositionBatchFn fn, void *arg)
+{
+    size_t cursor = 0, total = 0, len;
+    ChessPosition *batch = malloc(sizeof(ChessPosition) * batch_len);
+    if (!batch)
+    {
+        perror("Failed to allocate position batch");
+        exit(1);
+    }
+    while ((len = position_database_next_batch(db, &cursor, batch, batch_len)) > 0)
+    {
+        fn(batch, len, arg);
+        total += len;
+    }
+    free(batch);
+    return total;
+}
+
+int position_database_create(PositionDatabaseWriter *writer, const char *filename)
+{
+    unsigned char header[CHESS_PACK_HEADER_LEN];
+    writer->len = 0;
+    writer->f = fopen(filename, "wb");
+    if (!writer->f)
+    {
+        fprintf(stderr, "Failed to open file '%s'\n", filename);
+        return -1;
+    }
+    chess_pack_write_header(header);
+    fwrite(header, 1, sizeof(header), writer->f);
+    return 0;
+}
+
+void position_database_append(PositionDatabaseWriter *writer, ChessPosition *pos)
+{
+    ChessPackedPosition packed;
+    chess_position_pack(pos, &packed);
+    fwrite(packed.bytes, 1, CHESS_PACKED_LEN, writer->f);
+    writer->len++;
+}
+
+int position_database_finish(PositionDatabaseWriter *writer)
+{
+    int failed = ferror(writer->f);
+    if (fclose(writer->f) != 0)
+        failed = 1;
+    writer->f = NULL;
+    if (failed)
+    {
+        perror("Failed to write position database");
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <string.h>
+#include "../include/posdb.h"
+#include "../include/fen.h"
+#include "../include/movegen.h"
+#include "../include/eval.h"
+#include "../include/attacks.h"
+#include "../include/zobrist.h"
+
+#define POSDB_BATCH_LEN 4096
+#define POSDB_LINE_LEN 512
+
+typedef struct
+{
+    unsigned long long moves;
+    long long eval;
+} PosdbBenchTotals;
+
+static void usage(const char *exe)
+{
+    printf("usage: %s import <fen file> <db>    pack one FEN or EPD per line into a new database\n", exe);
+    printf("       %s export <db>               print the FEN of every record\n", exe);
+    printf("       %s bench <db>                generate moves and evaluate every record, reports positions/sec\n", exe);
+}
+
+static int posdb_import(const char *fen_filename, const char *db_filename)
+{
+    char line[POSDB_LINE_LEN];
+    unsigned long long skipped = 0;
+    PositionDatabaseWriter writer;
+    ChessPosition pos;
+    FILE *f = fopen(fen_filename, "r");
+    if (!f)
+    {
+        fprintf(stderr, "Failed to open file '%s'\n", fen_filename);
+        return 1;
+    }
+    if (position_database_create(&writer, db_filename) < 0)
+    {
+        fclose(f);
+        return 1;
+    }
+    while (fgets(line, sizeof(line), f))
+    {
+        if (chess_position_from_fen(&pos, line) < 0)
+        {
+            skipped++;
+            continue;
+        }
+        position_database_append(&writer, &pos);
+    }
+    fclose(f);
+    printf("Packed %zu positions, skipped %llu lines.\n", writer.len, skipped);
+    return position_database_finish(&writer) < 0;
+}
+
+static void posdb_print_batch(ChessPosition *batch, size_t len, void *arg)
+{
+    char fen[FEN_MAX_LEN];
+    size_t i;
+    (void)arg;
+    for (i = 0; i < len; i++)
+    {
+        chess_position_to_fen(&batch[i], fen);
+        printf("%s\n", fen);
+    }
+}
+
+static void posdb_bench_batch(ChessPosition *batch, size_t len, void *arg)
+{
+    PosdbBenchTotals *totals = (PosdbBenchTotals *)arg;
+    MoveList list;
+    size_t i;
+    for (i = 0; i < len; i++)
+    {
+        chess_position_generate_legal_moves(&batch[i], &list);
+        totals->moves += list.len;
+        totals->eval += chess_position_evaluate(&batch[i], NULL);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    PositionDatabase db;
+    chess_attacks_init();
+    chess_zobrist_init();
+    if (argc == 4 && strcmp(argv[1], "import") == 0)
+        return posdb_import(argv[2], argv[3]);
+    if (argc != 3 || (strcmp(argv[1], "export") != 0 && strcmp(argv[1], "bench") != 0))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    if (position_database_open(&db, argv[2]) < 0)
+        return 1;
+    if (strcmp(argv[1], "export") == 0)
+    {
+        position_database_stream(&db, POSDB_BATCH_LEN, posdb_print_batch, NULL);
+    }
+    else
+    {
+        PosdbBenchTotals totals = {0, 0};
+        double start = get_time();
+        size_t n = position_database_stream(&db, POSDB_BATCH_LEN, posdb_bench_batch, &totals);
+        double elapsed = get_time() - start;
+        printf("%zu positions (%zu records), %llu legal moves, eval sum %lld\n", n, db.len, totals.moves, totals.eval);
+        printf("Time: %.3fs, %.0f positions/sec\n", elapsed, elapsed > 0 ? n / elapsed : 0.0);
+    }
+    position_database_close(&db);
+    return 0;
+}
@@ -0,0 +1,291 @@
+#include <string.h>
+#include "../include/san.h"
+#include "../include/movegen.h"
+
+/* piece letters, pawns have none */
+static const char SAN_PIECE_CHARS[KING + 1] = {0, 0, 'B', 'N', 'R', 'Q', 'K'};
+
+static ChessPieceType san_char_to_type(char c)
+{
+    switch (c)
+    {
+    case 'N':
+        return KNIGHT;
+    case 'B':
+        return BISHOP;
+    case 'R':
+        return ROOK;
+    case 'Q':
+        return QUEEN;
+    case 'K':
+        return KING;
+    default:
+        return NONE;
+    }
+}
+
+int chess_position_parse_san(ChessPosition *pos, MoveList *legal, const char *san, ChessMove *move)
+{
+    ChessPieceType type = PAWN, promotion = NONE;
+    int from_file = -1, from_rank = -1, to, matches = 0, i;
+    size_t len = strlen(san);
+    /* check marks and annotations */
+    while (len > 0 && strchr("+#!?", san[len - 1]))
+        len--;
+    /* en passant suffix some writers add */
+    if (len > 4 && strncmp(san + len - 4, "e.p.", 4) == 0)
+        len -= 4;
+    if (len >= 3 && (san[0] == 'O' || san[0] == '0'))
+    {
+        int queen_side = len >= 5 && san[3] == '-' && (san[4] == 'O' || san[4] == '0');
+        int flag = queen_side ? MOVE_QUEEN_CASTLE : MOVE_KING_CASTLE;
+        for (i = 0; i < legal->len; i++)
+        {
+            if (MOVE_FLAGS(legal->moves[i]) == flag)
+            {
+                *move = legal->moves[i];
+                return SAN_OK;
+            }
+        }
+        return SAN_NO_MATCH;
+    }
+    if (len > 0 && san_char_to_type(san[0]) != NONE)
+    {
+        type = san_char_to_type(san[0]);
+        san++;
+        len--;
+    }
+    /* promotion, e8=Q or e8Q */
+    if (len >= 3 && type == PAWN && san_char_to_type(san[len - 1]) != NONE)
+    {
+        promotion = san_char_to_type(san[len - 1]);
+        len -= san[len - 2] == '=' ? 2 : 1;
+    }
+    if (len < 2 || san[len - 2] < 'a' || san[len - 2] > 'h' || san[len - 1] < '1' || san[len - 1] > '8')
+        return SAN_NO_MATCH;
+    to = SQUARE(san[len - 2] - 'a', san[len - 1] - '1');
+    /* what is left is the origin file and rank and the capture mark */
+    for (i = 0; i < (int)len - 2; i++)
+    {
+        if (san[i] >= 'a' && san[i] <= 'h')
+            from_file = san[i] - 'a';
+        else if (san[i] >= '1' && san[i] <= '8')
+            from_rank = san[i] - '1';
+        else if (san[i] != 'x' && san[i] != ':' && san[i] != '-')
+            return SAN_NO_MATCH;
+    }
+    for (i = 0; i < legal->len; i++)
+    {
+        ChessMove m = legal->moves[i];
+        int from = MOVE_FROM(m);
+        if (MOVE_TO(m) != to || POS_TYPE_AT(pos, from) != type || MOVE_IS_CASTLE(m))
+            continue;
+        if ((from_file >= 0 && SQUARE_FILE(from) != from_file) || (from_rank >= 0 && SQUARE_RANK(from) != from_rank))
+            continue;
+        if (MOVE_IS_PROMOTION(m) ? (ChessPieceType)MOVE_PROMOTION_TYPE(m) != promotion : promotion != NONE)
+            continue;
+        *move = m;
+        matches++;
+    }
+    if (matches > 1)
+        return SAN_AMBIGUOUS;
+    return matches ? SAN_OK : SAN_NO_MATCH;
+}
+
+/* + if move gives check, # if it also leaves no legal reply, 0 otherwise */
+static char san_check_suffix(ChessPosition *pos, ChessMove move)
+{
+    ChessUndo undo;
+    char suffix = 0;
+    chess_position_make_move(pos, move, &undo);
+    if (chess_position_in_check(pos, pos->turn_color))
+    {
+        MoveList replies;
+        chess_position_generate_legal_moves(pos, &replies);
+        suffix = replies.len ? '+' : '#';
+    }
+    chess_position_unmake_move(pos, &undo);
+    return suffix;
+}
+
+/* others are the from squares of the other pieces of the same type that can move to the same square */
+static int san_write(ChessPosition *pos, ChessMove move, Bitboard others, char *san)
+{
+    int from = MOVE_FROM(move), to = MOVE_TO(move), len = 0;
+    char suffix;
+    ChessPieceType type = POS_TYPE_AT(pos, from);
+    if (MOVE_IS_CASTLE(move))
+    {
+        const char *castle = MOVE_FLAGS(move) == MOVE_QUEEN_CASTLE ? "O-O-O" : "O-O";
+        len = (int)strlen(castle);
+        memcpy(san, castle, len);
+    }
+    else
+    {
+        if (type == PAWN)
+        {
+            if (MOVE_IS_CAPTURE(move))
+                san[len++] = 'a' + SQUARE_FILE(from);
+        }
+        else
+        {
+            san[len++] = SAN_PIECE_CHARS[type];
+            /* the file tells them apart unless one shares it, then the rank, unless one shares that too */
+            if (others)
+            {
+                if (!(others & BB_FILE(SQUARE_FILE(from))))
+                    san[len++] = 'a' + SQUARE_FILE(from);
+                else if (!(others & BB_RANK(SQUARE_RANK(from))))
+                    san[len++] = '1' + SQUARE_RANK(from);
+                else
+                {
+                    san[len++] = 'a' + SQUARE_FILE(from);
+                    san[len++] = '1' + SQUARE_RANK(from);
+                }
+            }
+        }
+        if (MOVE_IS_CAPTURE(move))
+            san[len++] = 'x';
+        san[len++] = 'a' + SQUARE_FILE(to);
+        san[len++] = '1' + SQUARE_RANK(to);
+        if (MOVE_IS_PROMOTION(move))
+        {
+            san[len++] = '=';
+            san[len++] = SAN_PIECE_CHARS[MOVE_PROMOTION_TYPE(move)];
+        }
+    }
+    suffix = san_check_suffix(pos, move);
+    if (suffix)
+        san[len++] = suffix;
+    san[len] = 0;
+    return len;
+}
+
+int chess_position_move_to_san(ChessPosition *pos, MoveList *legal, ChessMove move, char *san)
+{
+    Bitboard others = 0;
+    int from = MOVE_FROM(move), i;
+    ChessPieceType type = POS_TYPE_AT(pos, from);
+    if (type != PAWN && type != KING)
+    {
+        for (i = 0; i < legal->len; i++)
+        {
+            int other = MOVE_FROM(legal->moves[i]);
+            if (MOVE_TO(legal->moves[i]) == MOVE_TO(move) && other != from && POS_TYPE_AT(pos, other) == type)
+                others |= BB_SQUARE(other);
+        }
+    }
+    return san_write(pos, move, others, san);
+}
+
+void chess_position_moves_to_san(ChessPosition *pos, MoveList *legal, SanList *ret)
+{
+    /* from squares of the moves to each square by piece type, only the entries the moves use are cleared */
+    Bitboard origins[KING + 1][CHESS_BOARD_LEN];
+    int i;
+    for (i = 0; i < legal->len; i++)
+        origins[POS_TYPE_AT(pos, MOVE_FROM(legal->moves[i]))][MOVE_TO(legal->moves[i])] = 0;
+    for (i = 0; i < legal->len; i++)
+        origins[POS_TYPE_AT(pos, MOVE_FROM(legal->moves[i]))][MOVE_TO(legal->moves[i])] |= BB_SQUARE(MOVE_FROM(legal->moves[i]));
+    for (i = 0; i < legal->len; i++)
+    {
+        ChessMove m = legal->moves[i];
+        int from = MOVE_FROM(m);
+        ChessPieceType type = POS_TYPE_AT(pos, from);
+        /* pawns name their file when they capture and there is only one king */
+        Bitboard others = type == PAWN || type == KING ? 0 : origins[type][MOVE_TO(m)] & ~BB_SQUARE(from);
+        san_write(pos, m, others, ret->labels[i]);
+    }
+    ret->len = legal->len;
+}
+
+/* FNV-1a of the first len chars of key */
+static unsigned move_index_hash(const char *key, size_t len)
+{
+    unsigned h = 2166136261u;
+    size_t i;
+    for (i = 0; i < len; i++)
+        h = (h ^ (unsigned char)key[i]) * 16777619u;
+    return h;
+}
+
+/* the slot holding the len chars of key, or the empty slot where they go */
+static MoveIndexEntry *move_index_slot(MoveIndex *index, const char *key, size_t len)
+{
+    unsigned i = move_index_hash(key, len) & (MOVE_INDEX_SLOTS - 1);
+    while (index->slots[i].key[0] && (strncmp(index->slots[i].key, key, len) != 0 || index->slots[i].key[len]))
+        i = (i + 1) & (MOVE_INDEX_SLOTS - 1);
+    return &index->slots[i];
+}
+
+static void move_index_insert(MoveIndex *index, const char *key, size_t len, int move)
+{
+    MoveIndexEntry *e = move_index_slot(index, key, len);
+    if (e->key[0])
+    {
+        if (e->move != move)
+            e->move = SAN_AMBIGUOUS;
+        return;
+    }
+    memcpy(e->key, key, len);
+    e->key[len] = 0;
+    e->move = move;
+    index->used[index->used_len++] = (short)(e - index->slots);
+}
+
+void move_index_init(MoveIndex *index)
+{
+    memset(index, 0, sizeof(MoveIndex));
+}
+
+void move_index_build(MoveIndex *index, ChessPosition *pos, MoveList *legal, SanList *labels)
+{
+    int i;
+    for (i = 0; i < index->used_len; i++)
+        index->slots[index->used[i]].key[0] = 0;
+    index->used_len = 0;
+    for (i = 0; i < legal->len; i++)
+    {
+        ChessMove m = legal->moves[i];
+        const char *san = labels->labels[i];
+        char key[SAN_MAX_LEN];
+        size_t len = strlen(san);
+        if (san[len - 1] == '+' || san[len - 1] == '#')
+            len--;
+        move_index_insert(index, san, len, i);
+        move_to_string(m, key);
+        move_index_insert(index, key, strlen(key), i);
+        if (MOVE_IS_CASTLE(m))
+        {
+            /* castling written with zeros */
+            memcpy(key, san, len);
+            key[0] = key[2] = '0';
+            if (len == 5)
+                key[4] = '0';
+            move_index_insert(index, key, len, i);
+        }
+        else if (POS_TYPE_AT(pos, MOVE_FROM(m)) != PAWN)
+        {
+            /* the SAN with no origin, the piece letter is followed by x or the destination */
+            size_t n = 0;
+            key[n++] = san[0];
+            if (MOVE_IS_CAPTURE(m))
+                key[n++] = 'x';
+            memcpy(key + n, san + len - 2, 2);
+            n += 2;
+            move_index_insert(index, key, n, i);
+        }
+    }
+}
+
+int move_index_find(MoveIndex *index, const char *text)
+{
+    size_t len = strlen(text);
+    MoveIndexEntry *e;
+    while (len > 0 && strchr("+#!? \t\r\n", text[len - 1]))
+        len--;
+    if (len == 0 || len >= SAN_MAX_LEN)
+        return SAN_NO_MATCH;
+    e = move_index_slot(index, text, len);
+    return e->key[0] ? e->move : SAN_NO_MATCH;
+}
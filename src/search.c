@@ -0,0 +1,489 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "../include/search.h"
+#include "../include/movegen.h"
+#include "../include/eval.h"
+#include "../include/see.h"
+#include "../include/syzygy.h"
+
+/* the clock is read once every this many nodes + 1 */
+#define SEARCH_CHECK_NODES 2047
+
+/* move ordering, the best move found so far goes first then captures that do not lose material by MVV-LVA,
+    killers, history and last the captures the exchange on their square says lose material
+*/
+#define ORDER_FIRST 3000000
+#define ORDER_CAPTURE 2000000
+#define ORDER_KILLER_1 1000001
+#define ORDER_KILLER_2 1000000
+#define ORDER_BAD_CAPTURE -1000000
+/* history scores are halved when one reaches this, so they stay below the killers */
+#define HISTORY_MAX 900000
+
+/* most valuable victim, least valuable attacker */
+static const int MVV_LVA_RANK[KING + 1] = {
+    [NONE] = 0,
+    [PAWN] = 1,
+    [KNIGHT] = 2,
+    [BISHOP] = 3,
+    [ROOK] = 4,
+    [QUEEN] = 5,
+    [KING] = 6,
+};
+
+struct SearchShared;
+
+typedef struct
+{
+    struct SearchShared *shared;
+    /* thread 0 returns the move and decides when to stop */
+    int id;
+    ChessPosition pos;
+    TranspositionTable *tt;
+    unsigned long long nodes;
+    unsigned long long tb_hits;
+    /* best move of the last iteration, searched first at the root */
+    ChessMove root_best;
+    /* quiet moves that caused a cutoff at each ply */
+    ChessMove killers[SEARCH_MAX_PLY][2];
+    /* [ChessColor][from][to] */
+    int history[2][CHESS_BOARD_LEN][CHESS_BOARD_LEN];
+    /* keys[ply] is the key of the position at that ply of the current line */
+    uint64_t keys[SEARCH_MAX_PLY + 1];
+    /* pawn structures this thread has evaluated, its own table of the caller's PawnTables */
+    PawnTable *pawns;
+} SearchThread;
+
+/* what the threads of one search have in common */
+typedef struct SearchShared
+{
+    SearchLimits limits;
+    int max_depth;
+    double start;
+    /* set by thread 0, every thread returns as soon as it sees it */
+    volatile int stop;
+    SearchThread *threads;
+    int threads_len;
+} SearchShared;
+
+/* the other threads' counts may be a little behind */
+static unsigned long long search_total_nodes(SearchShared *shared)
+{
+    unsigned long long nodes = 0;
+    int i;
+    for (i = 0; i < shared->threads_len; i++)
+        nodes += shared->threads[i].nodes;
+    return nodes;
+}
+
+static unsigned long long search_total_tb_hits(SearchShared *shared)
+{
+    unsigned long long tb_hits = 0;
+    int i;
+    for (i = 0; i < shared->threads_len; i++)
+        tb_hits += shared->threads[i].tb_hits;
+    return tb_hits;
+}
+
+static int search_should_stop(SearchThread *t)
+{
+    SearchShared *shared = t->shared;
+    if (t->id != 0)
+        return 0;
+    if (shared->limits.stop && *shared->limits.stop)
+        return 1;
+    if (shared->limits.max_nodes && (shared->threads_len == 1 || (t->nodes & SEARCH_CHECK_NODES) == 0) &&
+        search_total_nodes(shared) >= shared->limits.max_nodes)
+        return 1;
+    if (shared->limits.move_time > 0 && (t->nodes & SEARCH_CHECK_NODES) == 0 &&
+        get_time() - shared->start >= shared->limits.move_time)
+        return 1;
+    return 0;
+}
+
+/* mate and tablebase scores are stored as the distance from the stored position, not from the root */
+static int search_score_to_tt(int score, int ply)
+{
+    if (score >= SEARCH_TB_BOUND)
+        return score + ply;
+    if (score <= -SEARCH_TB_BOUND)
+        return score - ply;
+    return score;
+}
+
+static int search_score_from_tt(int score, int ply)
+{
+    if (score >= SEARCH_TB_BOUND)
+        return score - ply;
+    if (score <= -SEARCH_TB_BOUND)
+        return score + ply;
+    return score;
+}
+
+/* the position has been seen before on this line since the last capture or pawn move */
+static int search_is_repetition(SearchThread *t, int ply)
+{
+    int i;
+    for (i = ply - 4; i >= 0 && ply - i <= t->pos.fifty_move_rule_turn_count; i -= 2)
+        if (t->keys[i] == t->pos.key)
+            return 1;
+    return 0;
+}
+
+static void search_score_moves(SearchThread *t, MoveList *list, int *scores, int ply, ChessMove first)
+{
+    ChessPosition *pos = &t->pos;
+    int i;
+    for (i = 0; i < list->len; i++)
+    {
+        ChessMove m = list->moves[i];
+        int from = MOVE_FROM(m), to = MOVE_TO(m);
+        if (m == first)
+            scores[i] = ORDER_FIRST;
+        else if (MOVE_IS_CAPTURE(m) || (MOVE_IS_PROMOTION(m) && MOVE_PROMOTION_TYPE(m) == QUEEN))
+        {
+            ChessPieceType victim = MOVE_FLAGS(m) == MOVE_EN_PASSANT ? PAWN : POS_TYPE_AT(pos, to);
+            ChessPieceType attacker = POS_TYPE_AT(pos, from);
+            int order = MVV_LVA_RANK[victim] * 8 - MVV_LVA_RANK[attacker];
+            if (MOVE_IS_PROMOTION(m))
+                order += MVV_LVA_RANK[QUEEN] * 8;
+            /* taking something worth at least the piece that takes can't lose material, so only the rest is exchanged out */
+            if ((MOVE_IS_PROMOTION(m) || PIECE_VALUES[attacker] > PIECE_VALUES[victim]) && chess_position_see(pos, m) < 0)
+                scores[i] = ORDER_BAD_CAPTURE + order;
+            else
+                scores[i] = ORDER_CAPTURE + order;
+        }
+        else if (m == t->killers[ply][0])
+            scores[i] = ORDER_KILLER_1;
+        else if (m == t->killers[ply][1])
+            scores[i] = ORDER_KILLER_2;
+        else
+            scores[i] = t->history[pos->turn_color][from][to];
+    }
+}
+
+/* moves the best scoring move left in list to i and returns it */
+static ChessMove search_pick_move(MoveList *list, int *scores, int i)
+{
+    int best = i, j;
+    for (j = i + 1; j < list->len; j++)
+        if (scores[j] > scores[best])
+            best = j;
+    ChessMove m = list->moves[best];
+    int score = scores[best];
+    list->moves[best] = list->moves[i];
+    scores[best] = scores[i];
+    list->moves[i] = m;
+    scores[i] = score;
+    return m;
+}
+
+static void search_update_quiet_cutoff(SearchThread *t, ChessMove m, int depth, int ply)
+{
+    int (*history)[CHESS_BOARD_LEN] = t->history[t->pos.turn_color];
+    if (t->killers[ply][0] != m)
+    {
+        t->killers[ply][1] = t->killers[ply][0];
+        t->killers[ply][0] = m;
+    }
+    history[MOVE_FROM(m)][MOVE_TO(m)] += depth * depth;
+    if (history[MOVE_FROM(m)][MOVE_TO(m)] >= HISTORY_MAX)
+    {
+        int *h = &t->history[0][0][0];
+        int i;
+        for (i = 0; i < 2 * CHESS_BOARD_LEN * CHESS_BOARD_LEN; i++)
+            h[i] /= 2;
+    }
+}
+
+/* only captures and queen promotions, unless in check */
+static int search_quiescence(SearchThread *t, int alpha, int beta, int ply)
+{
+    ChessPosition *pos = &t->pos;
+    MoveList list;
+    int scores[MOVE_LIST_CAPACITY];
+    ChessUndo undo;
+    int i, best = -SEARCH_INFINITE;
+    t->nodes++;
+    if (search_should_stop(t))
+        t->shared->stop = 1;
+    if (t->shared->stop)
+        return 0;
+    if (ply >= SEARCH_MAX_PLY)
+        return chess_position_evaluate(pos, t->pawns);
+    int in_check = chess_position_in_check(pos, pos->turn_color);
+    if (!in_check)
+    {
+        /* the side to move can usually do at least as well as standing still */
+        best = chess_position_evaluate(pos, t->pawns);
+        if (best >= beta)
+            return best;
+        if (best > alpha)
+            alpha = best;
+    }
+    chess_position_generate_legal_moves(pos, &list);
+    if (in_check && list.len == 0)
+        return -SEARCH_MATE + ply;
+    search_score_moves(t, &list, scores, ply, MOVE_NONE);
+    for (i = 0; i < list.len; i++)
+    {
+        ChessMove m = search_pick_move(&list, scores, i);
+        /* the rest are quiet or lose material in the exchange */
+        if (!in_check && scores[i] < ORDER_CAPTURE)
+            break;
+        chess_position_make_move(pos, m, &undo);
+        int score = -search_quiescence(t, -beta, -alpha, ply + 1);
+        chess_position_unmake_move(pos, &undo);
+        if (t->shared->stop)
+            return 0;
+        if (score > best)
+        {
+            best = score;
+            if (score > alpha)
+            {
+                alpha = score;
+                if (alpha >= beta)
+                    break;
+            }
+        }
+    }
+    return best;
+}
+
+static int search_negamax(SearchThread *t, int depth, int alpha, int beta, int ply)
+{
+    ChessPosition *pos = &t->pos;
+    MoveList list;
+    int scores[MOVE_LIST_CAPACITY];
+    ChessUndo undo;
+    TTData entry;
+    ChessMove best_move = MOVE_NONE, tt_move = MOVE_NONE;
+    int i, alpha_start = alpha, best = -SEARCH_INFINITE;
+    if (ply >= SEARCH_MAX_PLY)
+        return chess_position_evaluate(pos, t->pawns);
+    int in_check = chess_position_in_check(pos, pos->turn_color);
+    /* look one ply further at checks so they are not cut off at the horizon */
+    if (in_check)
+        depth++;
+    if (depth <= 0)
+        return search_quiescence(t, alpha, beta, ply);
+    t->nodes++;
+    if (search_should_stop(t))
+        t->shared->stop = 1;
+    if (t->shared->stop)
+        return 0;
+    if (ply > 0 && (pos->fifty_move_rule_turn_count >= 100 || search_is_repetition(t, ply)))
+        return 0;
+    if (t->tt && transposition_table_probe(t->tt, pos->key, &entry))
+    {
+        tt_move = entry.move;
+        /* the root always searches so it has a move to return */
+        if (ply > 0 && entry.depth >= depth)
+        {
+            int score = search_score_from_tt(entry.score, ply);
+            if (entry.bound == TT_BOUND_EXACT ||
+                (entry.bound == TT_BOUND_LOWER && score >= beta) ||
+                (entry.bound == TT_BOUND_UPPER && score <= alpha))
+                return score;
+        }
+    }
+    /* right after a capture or pawn move, as the tables do not count towards the fifty move rule */
+    if (ply > 0 && pos->fifty_move_rule_turn_count == 0 && depth >= t->shared->limits.tb_probe_depth &&
+        bb_popcount(pos->all) <= syzygy_max_pieces())
+    {
+        int success;
+        SyzygyWdl wdl = chess_position_probe_wdl(pos, &success);
+        if (success)
+        {
+            /* cursed wins and blessed losses are draws a little better or worse than the rest */
+            int score = wdl == SYZYGY_WIN ? SEARCH_TB_WIN - ply : wdl == SYZYGY_LOSS ? -SEARCH_TB_WIN + ply : (int)wdl;
+            t->tb_hits++;
+            if (t->tt)
+                transposition_table_store(t->tt, pos->key, MOVE_NONE, search_score_to_tt(score, ply), SEARCH_MAX_PLY - 1, TT_BOUND_EXACT);
+            return score;
+        }
+    }
+    chess_position_generate_legal_moves(pos, &list);
+    if (list.len == 0)
+        return in_check ? -SEARCH_MATE + ply : 0;
+    if (ply == 0 && t->root_best != MOVE_NONE)
+        tt_move = t->root_best;
+    search_score_moves(t, &list, scores, ply, tt_move);
+    for (i = 0; i < list.len; i++)
+    {
+        ChessMove m = search_pick_move(&list, scores, i);
+        int score;
+        chess_position_make_move(pos, m, &undo);
+        t->keys[ply + 1] = pos->key;
+        if (i == 0)
+        {
+            score = -search_negamax(t, depth - 1, -beta, -alpha, ply + 1);
+        }
+        else
+        {
+            /* the first move is expected to be best, the rest only have to be shown worse */
+            score = -search_negamax(t, depth - 1, -alpha - 1, -alpha, ply + 1);
+            if (score > alpha && score < beta)
+                score = -search_negamax(t, depth - 1, -beta, -alpha, ply + 1);
+        }
+        chess_position_unmake_move(pos, &undo);
+        if (t->shared->stop)
+            return 0;
+        if (score > best)
+        {
+            best = score;
+            if (score > alpha)
+            {
+                alpha = score;
+                best_move = m;
+                if (ply == 0)
+                    t->root_best = m;
+                if (alpha >= beta)
+                {
+                    if (!MOVE_IS_CAPTURE(m))
+                        search_update_quiet_cutoff(t, m, depth, ply);
+                    break;
+                }
+            }
+        }
+    }
+    if (t->tt)
+    {
+        int bound = best >= beta ? TT_BOUND_LOWER : best > alpha_start ? TT_BOUND_EXACT : TT_BOUND_UPPER;
+        transposition_table_store(t->tt, pos->key, best_move, search_score_to_tt(best, ply), depth, bound);
+    }
+    return best;
+}
+
+/* iterative deepening from the root, thread 0 fills result */
+static void search_iterate(SearchThread *t, SearchResult *result)
+{
+    SearchShared *shared = t->shared;
+    /* half the helpers start one ply deeper so the threads are not all on the same depth */
+    int depth = 1 + (t->id & 1);
+    for (; depth <= shared->max_depth; depth++)
+    {
+        int i, score;
+        /* older history counts for less each iteration */
+        int *h = &t->history[0][0][0];
+        for (i = 0; i < 2 * CHESS_BOARD_LEN * CHESS_BOARD_LEN; i++)
+            h[i] /= 2;
+        score = search_negamax(t, depth, -SEARCH_INFINITE, SEARCH_INFINITE, 0);
+        /* a root move that beat the last best before the stop was searched fully, so root_best is still kept */
+        if (shared->stop)
+            break;
+        if (t->id != 0)
+            continue;
+        result->score = score;
+        result->depth = depth;
+        if (shared->limits.on_depth)
+        {
+            result->best_move = t->root_best;
+            result->nodes = search_total_nodes(shared);
+            result->tb_hits = search_total_tb_hits(shared);
+            result->time = get_time() - shared->start;
+            shared->limits.on_depth(result, shared->limits.arg);
+        }
+        if (score >= SEARCH_MATE_BOUND || score <= -SEARCH_MATE_BOUND)
+            break;
+        /* the next iteration takes several times longer, it would not finish */
+        if (shared->limits.move_time > 0 && get_time() - shared->start >= shared->limits.move_time / 2)
+            break;
+    }
+}
+
+static void *search_thread_main(void *arg)
+{
+    search_iterate((SearchThread *)arg, NULL);
+    return NULL;
+}
+
+void chess_position_search(ChessPosition *pos, const SearchLimits *limits, TranspositionTable *tt, PawnTables *pawns,
+                           SearchResult *result)
+{
+    MoveList list;
+    SearchShared shared;
+    /* used when the caller keeps no pawn tables */
+    PawnTables own_pawns;
+    pthread_t *handles;
+    int i;
+    memset(result, 0, sizeof(SearchResult));
+    chess_position_generate_legal_moves(pos, &list);
+    if (list.len == 0)
+    {
+        result->score = chess_position_in_check(pos, pos->turn_color) ? -SEARCH_MATE : 0;
+        return;
+    }
+    if (bb_popcount(pos->all) <= syzygy_max_pieces())
+    {
+        SyzygyWdl wdl;
+        double start = get_time();
+        result->best_move = chess_position_probe_root(pos, &wdl);
+        if (result->best_move != MOVE_NONE)
+        {
+            result->score = wdl == SYZYGY_WIN ? SEARCH_TB_WIN : wdl == SYZYGY_LOSS ? -SEARCH_TB_WIN : (int)wdl;
+            result->tb_hits = list.len;
+            result->time = get_time() - start;
+            if (limits->on_depth)
+                limits->on_depth(result, limits->arg);
+            return;
+        }
+    }
+    shared.limits = *limits;
+    shared.max_depth = SEARCH_MAX_PLY - 1;
+    if (limits->max_depth > 0 && limits->max_depth < shared.max_depth)
+        shared.max_depth = limits->max_depth;
+    shared.start = get_time();
+    shared.stop = 0;
+    shared.threads_len = limits->threads > 0 ? limits->threads : get_cpu_count();
+    /* the threads only help each other through the table */
+    if (!tt)
+        shared.threads_len = 1;
+    shared.threads = calloc(shared.threads_len, sizeof(SearchThread));
+    handles = malloc(sizeof(pthread_t) * shared.threads_len);
+    if (!shared.threads || !handles)
+    {
+        perror("Failed to allocate search");
+        exit(1);
+    }
+    if (tt)
+        transposition_table_new_search(tt);
+    if (!pawns)
+    {
+        pawn_tables_init(&own_pawns);
+        pawns = &own_pawns;
+    }
+    pawn_tables_reserve(pawns, shared.threads_len);
+    for (i = 0; i < shared.threads_len; i++)
+    {
+        SearchThread *t = &shared.threads[i];
+        t->shared = &shared;
+        t->id = i;
+        t->pos = *pos;
+        t->tt = tt;
+        t->pawns = &pawns->tables[i];
+        t->keys[0] = pos->key;
+    }
+    for (i = 1; i < shared.threads_len; i++)
+    {
+        if (pthread_create(&handles[i], NULL, search_thread_main, &shared.threads[i]) != 0)
+        {
+            perror("Failed to start search thread");
+            exit(1);
+        }
+    }
+    search_iterate(&shared.threads[0], result);
+    shared.stop = 1;
+    for (i = 1; i < shared.threads_len; i++)
+        pthread_join(handles[i], NULL);
+    SearchThread *main_thread = &shared.threads[0];
+    result->best_move = main_thread->root_best != MOVE_NONE ? main_thread->root_best : list.moves[0];
+    result->nodes = search_total_nodes(&shared);
+    result->tb_hits = search_total_tb_hits(&shared);
+    result->time = get_time() - shared.start;
+    free(shared.threads);
+    free(handles);
+    if (pawns == &own_pawns)
+        pawn_tables_free(&own_pawns);
+}
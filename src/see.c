@@ -0,0 +1,71 @@
+#include "../include/see.h"
+#include "../include/attacks.h"
+#include "../include/eval.h"
+
+/* exchanges on one square, a side has at most 16 pieces */
+#define SEE_MAX_DEPTH 32
+
+/* cheapest first */
+static const ChessPieceType SEE_ORDER[] = {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING};
+
+int chess_position_see(ChessPosition *pos, ChessMove move)
+{
+    int from = MOVE_FROM(move), to = MOVE_TO(move), gain[SEE_MAX_DEPTH], d = 0, i;
+    ChessColor side = pos->turn_color;
+    ChessPieceType attacker = POS_TYPE_AT(pos, from), captured = POS_TYPE_AT(pos, to);
+    Bitboard occupied = pos->all ^ BB_SQUARE(from), attackers;
+    Bitboard bishops = pos->pieces[WHITE][BISHOP] | pos->pieces[BLACK][BISHOP] |
+                       pos->pieces[WHITE][QUEEN] | pos->pieces[BLACK][QUEEN];
+    Bitboard rooks = pos->pieces[WHITE][ROOK] | pos->pieces[BLACK][ROOK] |
+                     pos->pieces[WHITE][QUEEN] | pos->pieces[BLACK][QUEEN];
+    if (MOVE_IS_CASTLE(move))
+        return 0;
+    if (MOVE_FLAGS(move) == MOVE_EN_PASSANT)
+    {
+        captured = PAWN;
+        occupied ^= BB_SQUARE(side == WHITE ? to - CHESS_BOARD_WIDTH : to + CHESS_BOARD_WIDTH);
+    }
+    gain[0] = PIECE_VALUES[captured];
+    if (MOVE_IS_PROMOTION(move))
+    {
+        attacker = MOVE_PROMOTION_TYPE(move);
+        gain[0] += PIECE_VALUES[attacker] - PIECE_VALUES[PAWN];
+    }
+    attackers = chess_position_attackers_to(pos, to, occupied) & occupied;
+    while (d + 1 < SEE_MAX_DEPTH)
+    {
+        Bitboard ours;
+        side = !side;
+        ours = attackers & pos->occupied[side];
+        if (!ours)
+            break;
+        for (i = 0; !(ours & pos->pieces[side][SEE_ORDER[i]]); i++)
+            ;
+        /* the king can only take last, when nothing is left to take it back */
+        if (SEE_ORDER[i] == KING && (attackers & pos->occupied[!side]))
+            break;
+        d++;
+        /* what this side wins by taking the piece that took last */
+        gain[d] = PIECE_VALUES[attacker] - gain[d - 1];
+        /* taking back can only make it worse for this side, so if it already does no better than
+            leaving the square alone the rest of the exchange does not matter */
+        if (-gain[d - 1] >= gain[d])
+            break;
+        occupied ^= BB_SQUARE(bb_lsb(ours & pos->pieces[side][SEE_ORDER[i]]));
+        attacker = SEE_ORDER[i];
+        /* pieces behind the one that took join in */
+        if (attacker == PAWN || attacker == BISHOP || attacker == QUEEN)
+            attackers |= bishop_attacks(to, occupied) & bishops;
+        if (attacker == ROOK || attacker == QUEEN)
+            attackers |= rook_attacks(to, occupied) & rooks;
+        attackers &= occupied;
+    }
+    /* each side only takes when it gains from it */
+    while (d > 0)
+    {
+        if (-gain[d - 1] < gain[d])
+            gain[d - 1] = -gain[d];
+        d--;
+    }
+    return gain[0];
+}
@@ -0,0 +1,359 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "../include/selfplay.h"
+#include "../include/movegen.h"
+#include "../include/fen.h"
+#include "../include/san.h"
+#include "../include/syzygy.h"
+
+/* lines of the openings file longer than this are not read */
+#define SELFPLAY_LINE_LEN 1024
+/* movetext lines are wrapped before this many chars */
+#define SELFPLAY_PGN_WIDTH 80
+
+const char *SELFPLAY_ENDING_NAMES[SELFPLAY_ENDINGS] = {
+    [SELFPLAY_CHECKMATE] = "checkmate",
+    [SELFPLAY_STALEMATE] = "stalemate",
+    [SELFPLAY_FIFTY_MOVES] = "fifty move rule",
+    [SELFPLAY_REPETITION] = "threefold repetition",
+    [SELFPLAY_INSUFFICIENT_MATERIAL] = "insufficient material",
+    [SELFPLAY_TABLEBASE] = "tablebase",
+    [SELFPLAY_MAX_PLIES] = "move limit",
+};
+
+static const char *SELFPLAY_RESULT_TAGS[SELFPLAY_RESULTS] = {
+    [SELFPLAY_WHITE_WINS] = "1-0",
+    [SELFPLAY_BLACK_WINS] = "0-1",
+    [SELFPLAY_DRAW] = "1/2-1/2",
+};
+
+/* everything one game needs, each game thread reuses its own for every game it plays */
+typedef struct
+{
+    ChessPosition start;
+    ChessPosition pos;
+    int plies;
+    /* sans[i] is the move played at ply i */
+    char (*sans)[SAN_MAX_LEN];
+    /* keys[i] is the key of the position before ply i, for repetitions */
+    uint64_t *keys;
+    SelfPlayEnding ending;
+    SelfPlayResult result;
+    /* the game as PGN */
+    char *text;
+} SelfPlayGame;
+
+typedef struct
+{
+    const SelfPlayOptions *options;
+    FILE *out;
+    SelfPlaySummary *summary;
+    /* next game to hand out, out and summary are also only used while holding lock */
+    int next_game;
+    pthread_mutex_t lock;
+} SelfPlayWork;
+
+/* splitmix64, each game has its own state so the threads do not share rand() */
+static uint64_t selfplay_random(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* neither side has the pieces to mate, bare kings or a king and one minor piece against a king */
+static int selfplay_is_insufficient_material(ChessPosition *pos)
+{
+    int c, minors = 0;
+    for (c = BLACK; c <= WHITE; c++)
+    {
+        if (pos->pieces[c][PAWN] | pos->pieces[c][ROOK] | pos->pieces[c][QUEEN])
+            return 0;
+        minors += bb_popcount(pos->pieces[c][BISHOP] | pos->pieces[c][KNIGHT]);
+    }
+    return minors <= 1;
+}
+
+/* the position before ply has been seen twice before since the last capture or pawn move */
+static int selfplay_is_threefold(SelfPlayGame *game)
+{
+    int i, seen = 1, first = game->plies - game->pos.fifty_move_rule_turn_count;
+    if (first < 0)
+        first = 0;
+    for (i = game->plies - 2; i >= first; i -= 2)
+    {
+        if (game->keys[i] == game->keys[game->plies] && ++seen == 3)
+            return 1;
+    }
+    return 0;
+}
+
+/* the tablebases have pos, sets *result to what they say it is with best play */
+static int selfplay_probe_tablebases(ChessPosition *pos, SelfPlayResult *result)
+{
+    int success, fifty = pos->fifty_move_rule_turn_count;
+    SyzygyWdl wdl;
+    if (bb_popcount(pos->all) > syzygy_max_pieces())
+        return 0;
+    wdl = chess_position_probe_wdl(pos, &success);
+    if (!success)
+        return 0;
+    /* a win can still be too far from the next capture or pawn move for the plies already played */
+    if ((wdl == SYZYGY_WIN || wdl == SYZYGY_LOSS) && fifty > 0)
+    {
+        int dtz = chess_position_probe_dtz(pos, &success);
+        if (success && (dtz < 0 ? -dtz : dtz) + fifty > 100)
+            wdl = SYZYGY_DRAW;
+    }
+    if (wdl == SYZYGY_WIN)
+        *result = pos->turn_color == WHITE ? SELFPLAY_WHITE_WINS : SELFPLAY_BLACK_WINS;
+    else if (wdl == SYZYGY_LOSS)
+        *result = pos->turn_color == WHITE ? SELFPLAY_BLACK_WINS : SELFPLAY_WHITE_WINS;
+    else
+        *result = SELFPLAY_DRAW;
+    return 1;
+}
+
+static void selfplay_play_game(const SelfPlayOptions *options, int index, TranspositionTable *tt, PawnTables *pawns,
+                               SelfPlayGame *game)
+{
+    uint64_t random = options->seed ^ ((uint64_t)index * 0xD1B54A32D192ED03ULL);
+    if (options->openings_len > 0)
+        game->start = options->openings[index % options->openings_len];
+    else
+        chess_position_from_fen(&game->start, FEN_START);
+    game->pos = game->start;
+    game->plies = 0;
+    /* plies played from the book, the random plies come after them */
+    int book_plies = 0, in_book = options->book != NULL;
+    while (1)
+    {
+        MoveList legal;
+        ChessMove move;
+        ChessUndo undo;
+        ChessPosition *pos = &game->pos;
+        game->keys[game->plies] = pos->key;
+        chess_position_generate_legal_moves(pos, &legal);
+        game->result = SELFPLAY_DRAW;
+        if (legal.len == 0)
+        {
+            game->ending = chess_position_in_check(pos, pos->turn_color) ? SELFPLAY_CHECKMATE : SELFPLAY_STALEMATE;
+            if (game->ending == SELFPLAY_CHECKMATE)
+                game->result = pos->turn_color == WHITE ? SELFPLAY_BLACK_WINS : SELFPLAY_WHITE_WINS;
+            return;
+        }
+        if (pos->fifty_move_rule_turn_count >= 100)
+            game->ending = SELFPLAY_FIFTY_MOVES;
+        else if (selfplay_is_threefold(game))
+            game->ending = SELFPLAY_REPETITION;
+        else if (selfplay_is_insufficient_material(pos))
+            game->ending = SELFPLAY_INSUFFICIENT_MATERIAL;
+        else if (selfplay_probe_tablebases(pos, &game->result))
+            game->ending = SELFPLAY_TABLEBASE;
+        else if (game->plies >= options->max_plies)
+            game->ending = SELFPLAY_MAX_PLIES;
+        else
+            game->ending = SELFPLAY_ENDINGS;
+        if (game->ending != SELFPLAY_ENDINGS)
+            return;
+        /* once the game leaves the book it does not look again */
+        if (in_book && (move = polyglot_book_pick(options->book, pos, selfplay_random(&random))) == MOVE_NONE)
+            in_book = 0;
+        if (in_book)
+            book_plies++;
+        else if (game->plies - book_plies < options->random_plies)
+            move = legal.moves[selfplay_random(&random) % legal.len];
+        else
+        {
+            SearchResult result;
+            chess_position_search(pos, &options->limits, tt, pawns, &result);
+            move = result.best_move;
+        }
+        chess_position_move_to_san(pos, &legal, move, game->sans[game->plies]);
+        chess_position_make_move(pos, move, &undo);
+        game->plies++;
+    }
+}
+
+/* writes the game to game->text, returns its length */
+static size_t selfplay_write_pgn(const SelfPlayOptions *options, int index, SelfPlayGame *game)
+{
+    char *c = game->text, fen[FEN_MAX_LEN];
+    const char *result = SELFPLAY_RESULT_TAGS[game->result];
+    int i, line_len = 0;
+    c += sprintf(c, "[Event \"c-chess self-play\"]\n[Site \"?\"]\n[Date \"????.??.??\"]\n[Round \"%d\"]\n", index + 1);
+    c += sprintf(c, "[White \"c-chess\"]\n[Black \"c-chess\"]\n[Result \"%s\"]\n", result);
+    if (options->openings_len > 0)
+    {
+        chess_position_to_fen(&game->start, fen);
+        c += sprintf(c, "[SetUp \"1\"]\n[FEN \"%s\"]\n", fen);
+    }
+    c += sprintf(c, "[PlyCount \"%d\"]\n[Termination \"%s\"]\n\n", game->plies,
+                 game->ending == SELFPLAY_MAX_PLIES || game->ending == SELFPLAY_TABLEBASE ? "adjudication" : "normal");
+    for (i = 0; i < game->plies; i++)
+    {
+        char move[SAN_MAX_LEN + 16];
+        int len, turn = game->start.num_turns + (i + (game->start.turn_color == BLACK)) / 2 + 1;
+        if ((i & 1) == (game->start.turn_color == BLACK))
+            len = sprintf(move, "%d. %s", turn, game->sans[i]);
+        else if (i == 0)
+            len = sprintf(move, "%d... %s", turn, game->sans[i]);
+        else
+            len = sprintf(move, "%s", game->sans[i]);
+        if (line_len + len + 1 >= SELFPLAY_PGN_WIDTH)
+        {
+            *c++ = '\n';
+            line_len = 0;
+        }
+        else if (line_len)
+        {
+            *c++ = ' ';
+            line_len++;
+        }
+        memcpy(c, move, len);
+        c += len;
+        line_len += len;
+    }
+    /* the ending as a comment before the result */
+    if (line_len && line_len + strlen(SELFPLAY_ENDING_NAMES[game->ending]) + strlen(result) + 4 >= SELFPLAY_PGN_WIDTH)
+        *c++ = '\n';
+    else if (line_len)
+        *c++ = ' ';
+    c += sprintf(c, "{%s} %s\n\n", SELFPLAY_ENDING_NAMES[game->ending], result);
+    return c - game->text;
+}
+
+static void *selfplay_worker(void *arg)
+{
+    SelfPlayWork *work = (SelfPlayWork *)arg;
+    const SelfPlayOptions *options = work->options;
+    TranspositionTable tt;
+    /* pawn structures don't depend on the game, so these are kept for every game of the worker */
+    PawnTables pawns;
+    SelfPlayGame game;
+    transposition_table_init(&tt, options->table_mb);
+    pawn_tables_init(&pawns);
+    game.sans = malloc(sizeof(*game.sans) * (options->max_plies + 1));
+    game.keys = malloc(sizeof(uint64_t) * (options->max_plies + 1));
+    /* the tags, and each move with its number, a space and a line break */
+    game.text = malloc(FEN_MAX_LEN + 512 + (size_t)(options->max_plies + 1) * (SAN_MAX_LEN + 16));
+    if (!game.sans || !game.keys || !game.text)
+    {
+        perror("Failed to allocate self-play game");
+        exit(1);
+    }
+    while (1)
+    {
+        pthread_mutex_lock(&work->lock);
+        int index = work->next_game++;
+        pthread_mutex_unlock(&work->lock);
+        if (index >= options->games)
+            break;
+        transposition_table_clear(&tt);
+        selfplay_play_game(options, index, &tt, &pawns, &game);
+        size_t len = selfplay_write_pgn(options, index, &game);
+        pthread_mutex_lock(&work->lock);
+        if (work->out)
+        {
+            fwrite(game.text, 1, len, work->out);
+            fflush(work->out);
+        }
+        work->summary->games++;
+        work->summary->plies += game.plies;
+        work->summary->results[game.result]++;
+        work->summary->endings[game.ending]++;
+        pthread_mutex_unlock(&work->lock);
+    }
+    transposition_table_free(&tt);
+    pawn_tables_free(&pawns);
+    free(game.sans);
+    free(game.keys);
+    free(game.text);
+    return NULL;
+}
+
+void selfplay_run(const SelfPlayOptions *options, FILE *out, SelfPlaySummary *summary)
+{
+    SelfPlayWork work;
+    pthread_t *handles;
+    int threads = options->threads > 0 ? options->threads : get_cpu_count(), i;
+    double start = get_time();
+    if (threads > options->games)
+        threads = options->games > 0 ? options->games : 1;
+    memset(summary, 0, sizeof(SelfPlaySummary));
+    work.options = options;
+    work.out = out;
+    work.summary = summary;
+    work.next_game = 0;
+    pthread_mutex_init(&work.lock, NULL);
+    if (threads == 1)
+        selfplay_worker(&work);
+    else
+    {
+        handles = malloc(sizeof(pthread_t) * threads);
+        if (!handles)
+        {
+            perror("Failed to allocate self-play threads");
+            exit(1);
+        }
+        for (i = 0; i < threads; i++)
+        {
+            if (pthread_create(&handles[i], NULL, selfplay_worker, &work) != 0)
+            {
+                perror("Failed to start self-play thread");
+                exit(1);
+            }
+        }
+        for (i = 0; i < threads; i++)
+            pthread_join(handles[i], NULL);
+        free(handles);
+    }
+    pthread_mutex_destroy(&work.lock);
+    summary->time = get_time() - start;
+}
+
+int selfplay_load_openings(const char *filename, ChessPosition **openings)
+{
+    char line[SELFPLAY_LINE_LEN];
+    int len = 0, cap = 0, line_number = 0;
+    FILE *f = fopen(filename, "r");
+    *openings = NULL;
+    if (!f)
+    {
+        fprintf(stderr, "Failed to open file '%s'\n", filename);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f))
+    {
+        char *fen = line;
+        line_number++;
+        while (*fen == ' ' || *fen == '\t')
+            fen++;
+        if (*fen == 0 || *fen == '\n' || *fen == '\r' || *fen == '#')
+            continue;
+        if (len == cap)
+        {
+            cap = cap ? cap * 2 : 64;
+            ChessPosition *tmp = realloc(*openings, sizeof(ChessPosition) * cap);
+            if (!tmp)
+            {
+                perror("Failed to allocate openings");
+                exit(1);
+            }
+            *openings = tmp;
+        }
+        if (chess_position_from_fen(&(*openings)[len], fen) < 0)
+        {
+            fprintf(stderr, "%s:%d is not a legal position\n", filename, line_number);
+            fclose(f);
+            free(*openings);
+            *openings = NULL;
+            return -1;
+        }
+        len++;
+    }
+    fclose(f);
+    return len;
+}
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <string.h>
+#include "../include/selfplay.h"
+#include "../include/attacks.h"
+#include "../include/zobrist.h"
+#include "../include/syzygy.h"
+#include "../include/book.h"
+
+#define SELFPLAY_DEFAULT_GAMES 100
+#define SELFPLAY_DEFAULT_RANDOM_PLIES 4
+
+static void usage(const char *exe)
+{
+    printf("usage: %s [options] <out.pgn>    play the engine against itself and write the games as PGN\n", exe);
+    printf("options:\n");
+    printf("       -n <games>      games to play, default %d\n", SELFPLAY_DEFAULT_GAMES);
+    printf("       -t <threads>    games played at once, default one per core\n");
+    printf("       -d <depth>      search each move to depth\n");
+    printf("       -m <ms>         search each move for ms milliseconds, default %d\n", (int)(SEARCH_DEFAULT_MOVE_TIME * 1000));
+    printf("       -N <nodes>      search each move for this many nodes\n");
+    printf("       -H <mb>         transposition table of each game thread, default %d\n", TT_DEFAULT_MB);
+    printf("       -o <file>       openings, one FEN per line, game i starts from line i mod the number of lines\n");
+    printf("       -r <plies>      random moves played from the opening, default %d\n", SELFPLAY_DEFAULT_RANDOM_PLIES);
+    printf("       -p <plies>      plies before a game is adjudicated a draw, default %d\n", SELFPLAY_DEFAULT_MAX_PLIES);
+    printf("       -s <seed>       seed of the random moves, default 0\n");
+    printf("       -T <dirs>       Syzygy tablebases, ':' separated, used by the searches and to adjudicate games\n");
+    printf("       -P <plies>      the searches only probe the tablebases this far from the horizon, default 0\n");
+    printf("       -b <book>       Polyglot .bin book the games are played from until they leave it\n");
+}
+
+int main(int argc, char **argv)
+{
+    SelfPlayOptions options = {0};
+    SelfPlaySummary summary;
+    PolyglotBook book;
+    const char *exe = argv[0];
+    int i, limited = 0;
+    chess_attacks_init();
+    chess_zobrist_init();
+    options.games = SELFPLAY_DEFAULT_GAMES;
+    options.limits.threads = 1;
+    options.table_mb = TT_DEFAULT_MB;
+    options.random_plies = SELFPLAY_DEFAULT_RANDOM_PLIES;
+    options.max_plies = SELFPLAY_DEFAULT_MAX_PLIES;
+    /* options come first */
+    while (argc > 3 && argv[1][0] == '-')
+    {
+        const char *value = argv[2];
+        if (strcmp(argv[1], "-n") == 0)
+            options.games = atoi(value);
+        else if (strcmp(argv[1], "-t") == 0)
+            options.threads = atoi(value);
+        else if (strcmp(argv[1], "-d") == 0)
+            limited = options.limits.max_depth = atoi(value);
+        else if (strcmp(argv[1], "-m") == 0)
+            limited = (options.limits.move_time = atoi(value) / 1000.0) > 0;
+        else if (strcmp(argv[1], "-N") == 0)
+            limited = (options.limits.max_nodes = strtoull(value, NULL, 10)) > 0;
+        else if (strcmp(argv[1], "-H") == 0 && atoi(value) > 0)
+            options.table_mb = atoi(value);
+        else if (strcmp(argv[1], "-o") == 0 && !options.openings)
+        {
+            options.openings_len = selfplay_load_openings(value, &options.openings);
+            if (options.openings_len <= 0)
+            {
+                fprintf(stderr, "No openings in '%s'\n", value);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[1], "-r") == 0)
+            options.random_plies = atoi(value);
+        else if (strcmp(argv[1], "-p") == 0 && atoi(value) > 0)
+            options.max_plies = atoi(value);
+        else if (strcmp(argv[1], "-s") == 0)
+            options.seed = strtoull(value, NULL, 10);
+        else if (strcmp(argv[1], "-T") == 0)
+        {
+            if (syzygy_init(value) == 0)
+            {
+                fprintf(stderr, "No tablebases in '%s'\n", value);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[1], "-P") == 0)
+            options.limits.tb_probe_depth = atoi(value);
+        else if (strcmp(argv[1], "-b") == 0 && !options.book)
+        {
+            if (polyglot_book_open(&book, value) < 0)
+                return 1;
+            options.book = &book;
+        }
+        else
+        {
+            usage(exe);
+            return 1;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+    /* a lone option such as -h is not an output file */
+    if (argc != 2 || argv[1][0] == '-' || options.games <= 0)
+    {
+        usage(exe);
+        return 1;
+    }
+    if (!limited)
+        options.limits.move_time = SEARCH_DEFAULT_MOVE_TIME;
+    FILE *out = fopen(argv[1], "w");
+    if (!out)
+    {
+        fprintf(stderr, "Failed to open file '%s'\n", argv[1]);
+        return 1;
+    }
+    selfplay_run(&options, out, &summary);
+    fclose(out);
+    printf("%d games, %llu plies in %.2fs, %.2f games/sec, %.0f plies/sec\n", summary.games, summary.plies, summary.time,
+           summary.games / summary.time, summary.plies / summary.time);
+    printf("white wins %d, black wins %d, draws %d\n", summary.results[SELFPLAY_WHITE_WINS],
+           summary.results[SELFPLAY_BLACK_WINS], summary.results[SELFPLAY_DRAW]);
+    for (i = 0; i < SELFPLAY_ENDINGS; i++)
+    {
+        if (summary.endings[i])
+            printf("%6d %s\n", summary.endings[i], SELFPLAY_ENDING_NAMES[i]);
+    }
+    free(options.openings);
+    if (options.book)
+        polyglot_book_close(options.book);
+    syzygy_free();
+    return 0;
+}
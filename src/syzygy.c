@@ -0,0 +1,1282 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SYZYGY_PATH_SEPARATOR ':'
+#else
+#include <windows.h>
+#define SYZYGY_PATH_SEPARATOR ';'
+#endif
+#include <stdio.h>
+#include <string.h>
+#include "../include/syzygy.h"
+#include "../include/attacks.h"
+#include "../include/movegen.h"
+#include "../include/fen.h"
+
+/* the first 4 bytes of each file, little endian */
+#define SYZYGY_WDL_MAGIC 0x5D23E871u
+#define SYZYGY_DTZ_MAGIC 0xA50C66D7u
+/* table names are at most this long, as in KQRvKQ */
+#define SYZYGY_NAME_LEN (SYZYGY_MAX_PIECES + 2)
+/* each table is found under its key and its key with the colors swapped, a power of two */
+#define SYZYGY_KEY_SLOTS 4096
+#define SYZYGY_PATH_LEN 1024
+/* ranks the root moves, past any distance a table stores */
+#define SYZYGY_MAX_DTZ 1000
+
+/* the first byte of a file */
+#define SYZYGY_SPLIT 1
+#define SYZYGY_HAS_PAWNS 2
+
+/* SyzygyPairs.flags */
+#define SYZYGY_FLAG_STM 1
+#define SYZYGY_FLAG_MAPPED 2
+#define SYZYGY_FLAG_WIN_PLIES 4
+#define SYZYGY_FLAG_LOSS_PLIES 8
+#define SYZYGY_FLAG_WIDE 16
+#define SYZYGY_FLAG_SINGLE_VALUE 128
+
+/* the pieces as the files number them, black adds 8 */
+static const int SYZYGY_PIECE_CODES[KING + 1] = {
+    [NONE] = 0,
+    [PAWN] = 1,
+    [KNIGHT] = 2,
+    [BISHOP] = 3,
+    [ROOK] = 4,
+    [QUEEN] = 5,
+    [KING] = 6,
+};
+
+/* the pieces other than the king in the order table names list them */
+static const ChessPieceType SYZYGY_NAME_ORDER[] = {QUEEN, ROOK, BISHOP, KNIGHT, PAWN};
+static const char SYZYGY_NAME_CHARS[KING + 1] = {
+    [NONE] = 0,
+    [PAWN] = 'P',
+    [KNIGHT] = 'N',
+    [BISHOP] = 'B',
+    [ROOK] = 'R',
+    [QUEEN] = 'Q',
+    [KING] = 'K',
+};
+
+/* how probing a table went */
+typedef enum
+{
+    SYZYGY_FAIL,
+    SYZYGY_OK,
+    /* a DTZ table only stores one side to move, and it is the other one */
+    SYZYGY_CHANGE_STM,
+    /* the best move is a capture or pawn move, what the DTZ table stores can't be trusted */
+    SYZYGY_ZEROING_BEST_MOVE
+} SyzygyState;
+
+typedef struct
+{
+    const uint8_t *data;
+    size_t len;
+#ifdef _WIN32
+    HANDLE file, mapping;
+#endif
+} SyzygyFile;
+
+/*
+    One compressed table of a file, a file has one for each side to move and, with pawns, each file a-d of the leading pawn.
+    The values are Huffman coded pairs of symbols (recursive pairing) in blocks of size_of_block bytes,
+    sparse_index says which block each span of values starts in.
+*/
+typedef struct
+{
+    uint8_t flags;
+    /* the pieces in the order their squares are encoded */
+    uint8_t pieces[SYZYGY_MAX_PIECES];
+    /* pieces in each group, 0 terminated. group_idx[i] is what group i's index is multiplied by, the last one is the table size */
+    uint8_t group_len[SYZYGY_MAX_PIECES + 1];
+    uint64_t group_idx[SYZYGY_MAX_PIECES + 1];
+    uint64_t size_of_block;
+    uint64_t span;
+    uint64_t sparse_index_len;
+    uint64_t block_length_len;
+    uint64_t blocks_len;
+    const uint8_t *sparse_index;
+    const uint8_t *block_length;
+    const uint8_t *blocks;
+    /* the value of every position when flags has SYZYGY_FLAG_SINGLE_VALUE */
+    int min_sym_len;
+    int max_sym_len;
+    const uint8_t *lowest_sym;
+    /* base64[i] is the lowest code of length min_sym_len + i, left aligned */
+    uint64_t *base64;
+    /* the two symbols each symbol stands for, 12 bits each */
+    const uint8_t *btree;
+    /* symlen[s] + 1 values are coded by symbol s */
+    uint8_t *symlen;
+    int symbols;
+    /* DTZ only, where each result's values start in the table's map */
+    uint16_t map_idx[4];
+} SyzygyPairs;
+
+typedef struct
+{
+    char name[SYZYGY_NAME_LEN];
+    /* material of the named side as white, and as black */
+    uint64_t key;
+    uint64_t key2;
+    int pieces;
+    int has_pawns;
+    /* some piece other than a king is alone of its type and color, the first three pieces are then encoded together */
+    int has_unique_pieces;
+    /* pawns of the side the pawns are encoded from, then the other side */
+    int pawn_count[2];
+    SyzygyFile wdl_file;
+    SyzygyFile dtz_file;
+    int has_wdl;
+    int has_dtz;
+    /* [side to move][file of the leading pawn] */
+    SyzygyPairs wdl[2][4];
+    SyzygyPairs dtz[4];
+    const uint8_t *dtz_map;
+} SyzygyTable;
+
+static SyzygyTable *SYZYGY_TABLES = NULL;
+static int SYZYGY_TABLES_LEN = 0;
+static int SYZYGY_TABLES_CAP = 0;
+/* index + 1 of the table for each key, 0 for empty */
+static int SYZYGY_KEYS_TABLE[SYZYGY_KEY_SLOTS];
+static uint64_t SYZYGY_KEYS[SYZYGY_KEY_SLOTS];
+static int SYZYGY_LARGEST = 0;
+
+/* the square numbering the files use to encode positions */
+static int SYZYGY_MAP_B1H1H7[CHESS_BOARD_LEN];
+static int SYZYGY_MAP_A1D1D4[CHESS_BOARD_LEN];
+static int SYZYGY_MAP_KK[10][CHESS_BOARD_LEN];
+static int SYZYGY_MAP_PAWNS[CHESS_BOARD_LEN];
+static int SYZYGY_LEAD_PAWN_IDX[SYZYGY_MAX_PIECES][CHESS_BOARD_LEN];
+static int SYZYGY_LEAD_PAWNS_SIZE[SYZYGY_MAX_PIECES][4];
+/* [k][n] ways to choose k of n */
+static uint64_t SYZYGY_BINOMIAL[SYZYGY_MAX_PIECES][CHESS_BOARD_LEN];
+static int SYZYGY_ENCODING_READY = 0;
+
+static uint16_t syzygy_read_le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t syzygy_read_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t syzygy_read_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+/* rank minus file, 0 on the a1-h8 diagonal and negative below it */
+static int syzygy_off_diagonal(int sq)
+{
+    return SQUARE_RANK(sq) - SQUARE_FILE(sq);
+}
+
+static void syzygy_init_encoding(void)
+{
+    int sq, code = 0, i, k, n, f;
+    int diagonal[4], diagonal_len = 0, both[CHESS_BOARD_LEN * 4][2], both_len = 0;
+    if (SYZYGY_ENCODING_READY)
+        return;
+    /* squares below the a1-h8 diagonal to 0..27 */
+    for (sq = 0; sq < CHESS_BOARD_LEN; sq++)
+        if (syzygy_off_diagonal(sq) < 0)
+            SYZYGY_MAP_B1H1H7[sq] = code++;
+    /* the a1-d1-d4 triangle to 0..9, the diagonal squares last */
+    code = 0;
+    for (sq = 0; sq <= SQUARE(3, 3); sq++)
+    {
+        if (SQUARE_FILE(sq) > 3)
+            continue;
+        if (syzygy_off_diagonal(sq) < 0)
+            SYZYGY_MAP_A1D1D4[sq] = code++;
+        else if (syzygy_off_diagonal(sq) == 0)
+            diagonal[diagonal_len++] = sq;
+    }
+    for (i = 0; i < diagonal_len; i++)
+        SYZYGY_MAP_A1D1D4[diagonal[i]] = code++;
+    /* the 462 ways to place two kings with the first in the triangle, both on the diagonal last */
+    code = 0;
+    for (i = 0; i < 10; i++)
+    {
+        for (sq = 0; sq <= SQUARE(3, 3); sq++)
+        {
+            int s2;
+            if (SQUARE_FILE(sq) > 3 || syzygy_off_diagonal(sq) > 0 || SYZYGY_MAP_A1D1D4[sq] != i || (i == 0 && sq != SQUARE(1, 0)))
+                continue;
+            for (s2 = 0; s2 < CHESS_BOARD_LEN; s2++)
+            {
+                if ((KING_ATTACKS[sq] | BB_SQUARE(sq)) & BB_SQUARE(s2))
+                    continue;
+                if (syzygy_off_diagonal(sq) == 0 && syzygy_off_diagonal(s2) > 0)
+                    continue;
+                if (syzygy_off_diagonal(sq) == 0 && syzygy_off_diagonal(s2) == 0)
+                {
+                    both[both_len][0] = i;
+                    both[both_len++][1] = s2;
+                }
+                else
+                    SYZYGY_MAP_KK[i][s2] = code++;
+            }
+        }
+    }
+    for (i = 0; i < both_len; i++)
+        SYZYGY_MAP_KK[both[i][0]][both[i][1]] = code++;
+    SYZYGY_BINOMIAL[0][0] = 1;
+    for (n = 1; n < CHESS_BOARD_LEN; n++)
+        for (k = 0; k < SYZYGY_MAX_PIECES && k <= n; k++)
+            SYZYGY_BINOMIAL[k][n] = (k > 0 ? SYZYGY_BINOMIAL[k - 1][n - 1] : 0) + (k < n ? SYZYGY_BINOMIAL[k][n - 1] : 0);
+    /* pawn squares a2-h7 to 0..47, the highest is the leading pawn: nearest the edge, then lowest */
+    code = 47;
+    for (k = 1; k < SYZYGY_MAX_PIECES; k++)
+    {
+        for (f = 0; f < 4; f++)
+        {
+            int idx = 0, r;
+            for (r = 1; r <= 6; r++)
+            {
+                sq = SQUARE(f, r);
+                if (k == 1)
+                {
+                    SYZYGY_MAP_PAWNS[sq] = code--;
+                    SYZYGY_MAP_PAWNS[sq ^ 7] = code--;
+                }
+                SYZYGY_LEAD_PAWN_IDX[k][sq] = idx;
+                idx += SYZYGY_BINOMIAL[k - 1][SYZYGY_MAP_PAWNS[sq]];
+            }
+            SYZYGY_LEAD_PAWNS_SIZE[k][f] = idx;
+        }
+    }
+    SYZYGY_ENCODING_READY = 1;
+}
+
+/* 4 bits for the count of each piece type and color, kings are not counted */
+static uint64_t syzygy_material_key(const int *white, const int *black)
+{
+    uint64_t key = 0;
+    int t;
+    for (t = PAWN; t < KING; t++)
+        key |= ((uint64_t)white[t] << (4 * t)) | ((uint64_t)black[t] << (4 * (t + 8)));
+    return key;
+}
+
+static uint64_t chess_position_material_key(ChessPosition *pos)
+{
+    int counts[2][KING + 1] = {{0}}, t;
+    for (t = PAWN; t < KING; t++)
+    {
+        counts[WHITE][t] = bb_popcount(pos->pieces[WHITE][t]);
+        counts[BLACK][t] = bb_popcount(pos->pieces[BLACK][t]);
+    }
+    return syzygy_material_key(counts[WHITE], counts[BLACK]);
+}
+
+static SyzygyTable *syzygy_find(uint64_t key)
+{
+    int i = (int)((key * 0x9E3779B97F4A7C15ULL) >> 52) & (SYZYGY_KEY_SLOTS - 1);
+    while (SYZYGY_KEYS_TABLE[i])
+    {
+        if (SYZYGY_KEYS[i] == key)
+            return &SYZYGY_TABLES[SYZYGY_KEYS_TABLE[i] - 1];
+        i = (i + 1) & (SYZYGY_KEY_SLOTS - 1);
+    }
+    return NULL;
+}
+
+static void syzygy_add_key(uint64_t key, int table)
+{
+    int i = (int)((key * 0x9E3779B97F4A7C15ULL) >> 52) & (SYZYGY_KEY_SLOTS - 1);
+    while (SYZYGY_KEYS_TABLE[i])
+    {
+        if (SYZYGY_KEYS[i] == key)
+            return;
+        i = (i + 1) & (SYZYGY_KEY_SLOTS - 1);
+    }
+    SYZYGY_KEYS[i] = key;
+    SYZYGY_KEYS_TABLE[i] = table + 1;
+}
+
+static int syzygy_map_file(SyzygyFile *file, const char *filename)
+{
+    memset(file, 0, sizeof(SyzygyFile));
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    file->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+    if (file->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file->file, &size) || size.QuadPart == 0)
+    {
+        if (file->file != INVALID_HANDLE_VALUE)
+            CloseHandle(file->file);
+        file->file = NULL;
+        return -1;
+    }
+    file->len = (size_t)size.QuadPart;
+    file->mapping = CreateFileMappingA(file->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (file->mapping)
+        file->data = (const uint8_t *)MapViewOfFile(file->mapping, FILE_MAP_READ, 0, 0, 0);
+    return file->data ? 0 : -1;
+#else
+    struct stat st;
+    void *map;
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    if (fstat(fd, &st) < 0 || st.st_size == 0)
+    {
+        close(fd);
+        return -1;
+    }
+    file->len = (size_t)st.st_size;
+    map = mmap(NULL, file->len, PROT_READ, MAP_PRIVATE, fd, 0);
+    /* the mapping keeps the file open */
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+    /* probes jump all over the file */
+    posix_madvise(map, file->len, POSIX_MADV_RANDOM);
+    file->data = (const uint8_t *)map;
+    return 0;
+#endif
+}
+
+static void syzygy_unmap_file(SyzygyFile *file)
+{
+#ifdef _WIN32
+    if (file->data)
+        UnmapViewOfFile(file->data);
+    if (file->mapping)
+        CloseHandle(file->mapping);
+    if (file->file)
+        CloseHandle(file->file);
+#else
+    if (file->data)
+        munmap((void *)file->data, file->len);
+#endif
+    memset(file, 0, sizeof(SyzygyFile));
+}
+
+static SyzygyPairs *syzygy_pairs(SyzygyTable *table, int dtz, int stm, int file)
+{
+    int f = table->has_pawns ? file : 0;
+    return dtz ? &table->dtz[f] : &table->wdl[stm][f];
+}
+
+/* the groups the pieces are encoded in, and what each group's index is multiplied by */
+static void syzygy_set_groups(SyzygyTable *table, SyzygyPairs *d, const int *order, int file)
+{
+    int n = 0, i, k, first_len = table->has_pawns ? 0 : table->has_unique_pieces ? 3 : 2;
+    int pp = table->has_pawns && table->pawn_count[1];
+    int next = pp ? 2 : 1;
+    uint64_t idx = 1;
+    d->group_len[n] = 1;
+    /* the leading group, then pieces of the same type and color together */
+    for (i = 1; i < table->pieces; i++)
+    {
+        if (--first_len > 0 || d->pieces[i] == d->pieces[i - 1])
+            d->group_len[n]++;
+        else
+            d->group_len[++n] = 1;
+    }
+    d->group_len[++n] = 0;
+    int free_squares = CHESS_BOARD_LEN - d->group_len[0] - (pp ? d->group_len[1] : 0);
+    /* the file says in which order the groups are multiplied */
+    for (k = 0; next < n || k == order[0] || k == order[1]; k++)
+    {
+        if (k == order[0])
+        {
+            d->group_idx[0] = idx;
+            idx *= table->has_pawns ? (uint64_t)SYZYGY_LEAD_PAWNS_SIZE[d->group_len[0]][file] : table->has_unique_pieces ? 31332 : 462;
+        }
+        else if (k == order[1])
+        {
+            d->group_idx[1] = idx;
+            idx *= SYZYGY_BINOMIAL[d->group_len[1]][48 - d->group_len[0]];
+        }
+        else
+        {
+            d->group_idx[next] = idx;
+            idx *= SYZYGY_BINOMIAL[d->group_len[next]][free_squares];
+            free_squares -= d->group_len[next++];
+        }
+    }
+    d->group_idx[n] = idx;
+}
+
+/* fills symlen of s and the symbols it stands for, -1 if the tree does not make sense */
+static int syzygy_set_symlen(SyzygyPairs *d, int s, uint8_t *visited)
+{
+    const uint8_t *lr = d->btree + 3 * s;
+    int right = (lr[2] << 4) | (lr[1] >> 4), left = ((lr[1] & 0xF) << 8) | lr[0], len;
+    visited[s] = 1;
+    d->symlen[s] = 0;
+    if (right == 0xFFF)
+        return 0;
+    if (left >= d->symbols || right >= d->symbols)
+        return -1;
+    if (!visited[left] && syzygy_set_symlen(d, left, visited) < 0)
+        return -1;
+    if (!visited[right] && syzygy_set_symlen(d, right, visited) < 0)
+        return -1;
+    len = d->symlen[left] + d->symlen[right] + 1;
+    if (len > 255)
+        return -1;
+    d->symlen[s] = len;
+    return 0;
+}
+
+/* reads the header of one compressed table from data, returns past it or NULL if it doesn't fit in end */
+static const uint8_t *syzygy_set_sizes(SyzygyPairs *d, const uint8_t *data, const uint8_t *end)
+{
+    int i;
+    uint64_t size;
+    if (data + 2 > end)
+        return NULL;
+    d->flags = *data++;
+    if (d->flags & SYZYGY_FLAG_SINGLE_VALUE)
+    {
+        d->min_sym_len = *data++;
+        return data;
+    }
+    if (data + 10 > end)
+        return NULL;
+    for (i = 0; d->group_len[i]; i++)
+        ;
+    size = d->group_idx[i];
+    if (data[0] >= 32 || data[1] >= 32)
+        return NULL;
+    d->size_of_block = (uint64_t)1 << *data++;
+    d->span = (uint64_t)1 << *data++;
+    d->sparse_index_len = (size + d->span - 1) / d->span;
+    int padding = *data++;
+    d->blocks_len = syzygy_read_le32(data);
+    data += 4;
+    /* padded so the sparse index never points past it */
+    d->block_length_len = d->blocks_len + padding;
+    d->max_sym_len = *data++;
+    d->min_sym_len = *data++;
+    if (d->min_sym_len < 1 || d->max_sym_len < d->min_sym_len || d->max_sym_len > 32)
+        return NULL;
+    int lengths = d->max_sym_len - d->min_sym_len + 1;
+    d->lowest_sym = data;
+    if (data + 2 * lengths + 2 > end)
+        return NULL;
+    d->base64 = malloc(sizeof(uint64_t) * lengths);
+    if (!d->base64)
+    {
+        perror("Failed to allocate tablebase");
+        exit(1);
+    }
+    /* longer codes have lower values, each length's first code follows from the next length's */
+    d->base64[lengths - 1] = 0;
+    for (i = lengths - 2; i >= 0; i--)
+        d->base64[i] = (d->base64[i + 1] + syzygy_read_le16(d->lowest_sym + 2 * i) - syzygy_read_le16(d->lowest_sym + 2 * (i + 1))) / 2;
+    for (i = 0; i < lengths; i++)
+        d->base64[i] <<= 64 - i - d->min_sym_len;
+    data += 2 * lengths;
+    d->symbols = syzygy_read_le16(data);
+    data += 2;
+    d->btree = data;
+    if (data + 3 * d->symbols > end)
+        return NULL;
+    d->symlen = calloc(d->symbols ? d->symbols : 1, 2);
+    if (!d->symlen)
+    {
+        perror("Failed to allocate tablebase");
+        exit(1);
+    }
+    /* the second half flags the symbols already worked out */
+    uint8_t *visited = d->symlen + d->symbols;
+    for (i = 0; i < d->symbols; i++)
+        if (!visited[i] && syzygy_set_symlen(d, i, visited) < 0)
+            return NULL;
+    return data + 3 * d->symbols + (d->symbols & 1);
+}
+
+/* DTZ values are stored as indexes into a map for each result */
+static const uint8_t *syzygy_set_dtz_map(SyzygyTable *table, const uint8_t *start, const uint8_t *data, const uint8_t *end, int files)
+{
+    int f, i;
+    table->dtz_map = data;
+    for (f = 0; f < files; f++)
+    {
+        SyzygyPairs *d = &table->dtz[f];
+        if (!(d->flags & SYZYGY_FLAG_MAPPED))
+            continue;
+        if (d->flags & SYZYGY_FLAG_WIDE)
+        {
+            /* 16 bit values start on an even byte */
+            data += (uintptr_t)(data - start) & 1;
+            for (i = 0; i < 4; i++)
+            {
+                if (data + 2 > end)
+                    return NULL;
+                d->map_idx[i] = (uint16_t)((data - table->dtz_map) / 2 + 1);
+                data += 2 * syzygy_read_le16(data) + 2;
+            }
+        }
+        else
+        {
+            for (i = 0; i < 4; i++)
+            {
+                if (data >= end)
+                    return NULL;
+                d->map_idx[i] = (uint16_t)(data - table->dtz_map + 1);
+                data += *data + 1;
+            }
+        }
+    }
+    return data + ((uintptr_t)(data - start) & 1);
+}
+
+/* reads the file's headers after the magic, returns -1 if they do not fit in it */
+static int syzygy_set(SyzygyTable *table, int dtz, const uint8_t *start, size_t len)
+{
+    const uint8_t *data = start + 4, *end = start + len;
+    int sides = !dtz && table->key != table->key2 ? 2 : 1;
+    int files = table->has_pawns ? 4 : 1;
+    int pp = table->has_pawns && table->pawn_count[1];
+    int f, i, k;
+    if ((*data & SYZYGY_HAS_PAWNS) != (table->has_pawns ? SYZYGY_HAS_PAWNS : 0))
+        return -1;
+    data++;
+    for (f = 0; f < files; f++)
+    {
+        int order[2][2];
+        if (data + 1 + pp + table->pieces > end)
+            return -1;
+        order[0][0] = *data & 0xF;
+        order[0][1] = pp ? data[1] & 0xF : 0xF;
+        order[1][0] = *data >> 4;
+        order[1][1] = pp ? data[1] >> 4 : 0xF;
+        data += 1 + pp;
+        for (k = 0; k < table->pieces; k++, data++)
+            for (i = 0; i < sides; i++)
+                syzygy_pairs(table, dtz, i, f)->pieces[k] = i ? *data >> 4 : *data & 0xF;
+        for (i = 0; i < sides; i++)
+            syzygy_set_groups(table, syzygy_pairs(table, dtz, i, f), order[i], f);
+    }
+    data += (uintptr_t)(data - start) & 1;
+    for (f = 0; f < files; f++)
+        for (i = 0; i < sides; i++)
+            if (!(data = syzygy_set_sizes(syzygy_pairs(table, dtz, i, f), data, end)))
+                return -1;
+    if (dtz && !(data = syzygy_set_dtz_map(table, start, data, end, files)))
+        return -1;
+    for (f = 0; f < files; f++)
+        for (i = 0; i < sides; i++)
+        {
+            SyzygyPairs *d = syzygy_pairs(table, dtz, i, f);
+            d->sparse_index = data;
+            data += d->sparse_index_len * 6;
+        }
+    for (f = 0; f < files; f++)
+        for (i = 0; i < sides; i++)
+        {
+            SyzygyPairs *d = syzygy_pairs(table, dtz, i, f);
+            d->block_length = data;
+            data += d->block_length_len * 2;
+        }
+    for (f = 0; f < files; f++)
+        for (i = 0; i < sides; i++)
+        {
+            SyzygyPairs *d = syzygy_pairs(table, dtz, i, f);
+            /* blocks start on 64 byte boundaries */
+            data = start + (((uintptr_t)(data - start) + 0x3F) & ~(uintptr_t)0x3F);
+            d->blocks = data;
+            data += d->blocks_len * d->size_of_block;
+        }
+    return data > end ? -1 : 0;
+}
+
+static void syzygy_free_pairs(SyzygyPairs *d)
+{
+    free(d->base64);
+    free(d->symlen);
+    d->base64 = NULL;
+    d->symlen = NULL;
+}
+
+/* maps and reads one file of table, returns 0 if it is there and can be used */
+static int syzygy_load(SyzygyTable *table, int dtz, const char *dir)
+{
+    char filename[SYZYGY_PATH_LEN + SYZYGY_NAME_LEN + 8];
+    SyzygyFile *file = dtz ? &table->dtz_file : &table->wdl_file;
+    snprintf(filename, sizeof(filename), "%s/%s%s", dir, table->name, dtz ? ".rtbz" : ".rtbw");
+    if (syzygy_map_file(file, filename) < 0)
+        return -1;
+    /* every file is some 64 byte blocks and 16 bytes of header */
+    if (file->len % 64 != 16 || syzygy_read_le32(file->data) != (dtz ? SYZYGY_DTZ_MAGIC : SYZYGY_WDL_MAGIC) ||
+        syzygy_set(table, dtz, file->data, file->len) < 0)
+    {
+        int f;
+        fprintf(stderr, "'%s' is not a Syzygy tablebase file\n", filename);
+        for (f = 0; f < 4; f++)
+        {
+            if (dtz)
+                syzygy_free_pairs(&table->dtz[f]);
+            else
+            {
+                syzygy_free_pairs(&table->wdl[0][f]);
+                syzygy_free_pairs(&table->wdl[1][f]);
+            }
+        }
+        syzygy_unmap_file(file);
+        return -1;
+    }
+    return 0;
+}
+
+/* looks for the table of white with wcounts and black with bcounts in each directory of path */
+static void syzygy_add(const char *path, const int *wcounts, const int *bcounts)
+{
+    SyzygyTable *table;
+    char name[SYZYGY_NAME_LEN], *c = name;
+    int i, j, t;
+    uint64_t key = syzygy_material_key(wcounts, bcounts), key2 = syzygy_material_key(bcounts, wcounts);
+    if (syzygy_find(key))
+        return;
+    *c++ = 'K';
+    for (i = 0; i < 5; i++)
+        for (j = 0; j < wcounts[SYZYGY_NAME_ORDER[i]]; j++)
+            *c++ = SYZYGY_NAME_CHARS[SYZYGY_NAME_ORDER[i]];
+    *c++ = 'v';
+    *c++ = 'K';
+    for (i = 0; i < 5; i++)
+        for (j = 0; j < bcounts[SYZYGY_NAME_ORDER[i]]; j++)
+            *c++ = SYZYGY_NAME_CHARS[SYZYGY_NAME_ORDER[i]];
+    *c = 0;
+    if (SYZYGY_TABLES_LEN == SYZYGY_TABLES_CAP)
+    {
+        SYZYGY_TABLES_CAP = SYZYGY_TABLES_CAP ? SYZYGY_TABLES_CAP * 2 : 64;
+        SyzygyTable *tmp = realloc(SYZYGY_TABLES, sizeof(SyzygyTable) * SYZYGY_TABLES_CAP);
+        if (!tmp)
+        {
+            perror("Failed to allocate tablebases");
+            exit(1);
+        }
+        SYZYGY_TABLES = tmp;
+    }
+    table = &SYZYGY_TABLES[SYZYGY_TABLES_LEN];
+    memset(table, 0, sizeof(SyzygyTable));
+    strcpy(table->name, name);
+    table->key = key;
+    table->key2 = key2;
+    table->pieces = 2;
+    for (t = PAWN; t < KING; t++)
+    {
+        table->pieces += wcounts[t] + bcounts[t];
+        if (wcounts[t] == 1 || bcounts[t] == 1)
+            table->has_unique_pieces = 1;
+    }
+    table->has_pawns = wcounts[PAWN] + bcounts[PAWN] > 0;
+    /* the pawns are encoded from the side with fewer of them, white if it's the same */
+    int white_leads = !bcounts[PAWN] || (wcounts[PAWN] && bcounts[PAWN] >= wcounts[PAWN]);
+    table->pawn_count[0] = white_leads ? wcounts[PAWN] : bcounts[PAWN];
+    table->pawn_count[1] = white_leads ? bcounts[PAWN] : wcounts[PAWN];
+    /* the first directory that has it */
+    while (*path)
+    {
+        char dir[SYZYGY_PATH_LEN];
+        const char *sep = strchr(path, SYZYGY_PATH_SEPARATOR);
+        size_t len = sep ? (size_t)(sep - path) : strlen(path);
+        if (len > 0 && len < sizeof(dir))
+        {
+            memcpy(dir, path, len);
+            dir[len] = 0;
+            if (!table->has_wdl && syzygy_load(table, 0, dir) == 0)
+                table->has_wdl = 1;
+            if (!table->has_dtz && syzygy_load(table, 1, dir) == 0)
+                table->has_dtz = 1;
+        }
+        path += sep ? len + 1 : len;
+    }
+    if (!table->has_wdl)
+    {
+        for (i = 0; i < 4; i++)
+            syzygy_free_pairs(&table->dtz[i]);
+        syzygy_unmap_file(&table->dtz_file);
+        return;
+    }
+    syzygy_add_key(key, SYZYGY_TABLES_LEN);
+    syzygy_add_key(key2, SYZYGY_TABLES_LEN);
+    SYZYGY_TABLES_LEN++;
+    if (table->pieces > SYZYGY_LARGEST)
+        SYZYGY_LARGEST = table->pieces;
+}
+
+/* counts[type] of the pieces other than kings, with types no greater than max_type in name order, up to left more pieces */
+static void syzygy_add_sides(const char *path, int *wcounts, int *bcounts, int side, int first_type, int left)
+{
+    int i;
+    if (side == 0)
+        syzygy_add_sides(path, wcounts, bcounts, 1, 0, left);
+    else if (wcounts[PAWN] + wcounts[KNIGHT] + wcounts[BISHOP] + wcounts[ROOK] + wcounts[QUEEN] > 0)
+        syzygy_add(path, wcounts, bcounts);
+    if (left == 0)
+        return;
+    /* each side's pieces are picked in name order so each set of pieces is tried once */
+    for (i = first_type; i < 5; i++)
+    {
+        int *counts = side == 0 ? wcounts : bcounts;
+        counts[SYZYGY_NAME_ORDER[i]]++;
+        syzygy_add_sides(path, wcounts, bcounts, side, i, left - 1);
+        counts[SYZYGY_NAME_ORDER[i]]--;
+    }
+}
+
+void syzygy_free(void)
+{
+    int i, f;
+    for (i = 0; i < SYZYGY_TABLES_LEN; i++)
+    {
+        SyzygyTable *table = &SYZYGY_TABLES[i];
+        for (f = 0; f < 4; f++)
+        {
+            syzygy_free_pairs(&table->wdl[0][f]);
+            syzygy_free_pairs(&table->wdl[1][f]);
+            syzygy_free_pairs(&table->dtz[f]);
+        }
+        syzygy_unmap_file(&table->wdl_file);
+        syzygy_unmap_file(&table->dtz_file);
+    }
+    free(SYZYGY_TABLES);
+    SYZYGY_TABLES = NULL;
+    SYZYGY_TABLES_LEN = SYZYGY_TABLES_CAP = 0;
+    memset(SYZYGY_KEYS_TABLE, 0, sizeof(SYZYGY_KEYS_TABLE));
+    SYZYGY_LARGEST = 0;
+}
+
+static int syzygy_check_tables(void);
+
+int syzygy_init(const char *path)
+{
+    int wcounts[KING + 1] = {0}, bcounts[KING + 1] = {0};
+    syzygy_free();
+    if (!path || !*path)
+        return 0;
+    syzygy_init_encoding();
+    syzygy_add_sides(path, wcounts, bcounts, 0, 0, SYZYGY_MAX_PIECES - 2);
+    if (SYZYGY_LARGEST && syzygy_check_tables() < 0)
+    {
+        fprintf(stderr, "The tablebases in '%s' give wrong results for known positions, they are not used\n", path);
+        syzygy_free();
+    }
+    return SYZYGY_LARGEST;
+}
+
+int syzygy_max_pieces(void)
+{
+    return SYZYGY_LARGEST;
+}
+
+/* the value at idx of a compressed table, -1 if the table does not make sense there */
+static int syzygy_decompress_pairs(SyzygyPairs *d, uint64_t idx)
+{
+    uint64_t k, block;
+    int offset, sym, len;
+    if (d->flags & SYZYGY_FLAG_SINGLE_VALUE)
+        return d->min_sym_len;
+    /* the sparse index has the block and offset in it of the value in the middle of each span */
+    k = idx / d->span;
+    if (k >= d->sparse_index_len)
+        return -1;
+    block = syzygy_read_le32(d->sparse_index + 6 * k);
+    offset = syzygy_read_le16(d->sparse_index + 6 * k + 4);
+    offset += (int)(idx % d->span) - (int)(d->span / 2);
+    /* each block has block_length + 1 values */
+    while (offset < 0)
+    {
+        if (block == 0)
+            return -1;
+        offset += syzygy_read_le16(d->block_length + 2 * --block) + 1;
+    }
+    while (block < d->block_length_len && offset > syzygy_read_le16(d->block_length + 2 * block))
+        offset -= syzygy_read_le16(d->block_length + 2 * block++) + 1;
+    if (block >= d->blocks_len)
+        return -1;
+    /* big endian Huffman codes, read 32 bits at a time */
+    const uint8_t *ptr = d->blocks + block * d->size_of_block;
+    uint64_t buf = ((uint64_t)syzygy_read_be32(ptr) << 32) | syzygy_read_be32(ptr + 4);
+    int buf_bits = 64;
+    ptr += 8;
+    while (1)
+    {
+        len = 0;
+        while (len < d->max_sym_len - d->min_sym_len && buf < d->base64[len])
+            len++;
+        sym = (int)((buf - d->base64[len]) >> (64 - len - d->min_sym_len)) + syzygy_read_le16(d->lowest_sym + 2 * len);
+        if (sym >= d->symbols)
+            return -1;
+        if (offset < d->symlen[sym] + 1)
+            break;
+        offset -= d->symlen[sym] + 1;
+        len += d->min_sym_len;
+        buf <<= len;
+        buf_bits -= len;
+        if (buf_bits <= 32)
+        {
+            buf_bits += 32;
+            buf |= (uint64_t)syzygy_read_be32(ptr) << (64 - buf_bits);
+            ptr += 4;
+        }
+    }
+    /* the symbol stands for a pair of symbols, go down to the one the value is in */
+    while (d->symlen[sym])
+    {
+        const uint8_t *lr = d->btree + 3 * sym;
+        int left = ((lr[1] & 0xF) << 8) | lr[0];
+        if (offset < d->symlen[left] + 1)
+            sym = left;
+        else
+        {
+            offset -= d->symlen[left] + 1;
+            sym = (lr[2] << 4) | (lr[1] >> 4);
+        }
+    }
+    return ((d->btree[3 * sym + 1] & 0xF) << 8) | d->btree[3 * sym];
+}
+
+static int syzygy_pawns_before(int a, int b)
+{
+    return SYZYGY_MAP_PAWNS[a] < SYZYGY_MAP_PAWNS[b];
+}
+
+/* the value the table stores for pos, wdl is the result when it is a DTZ table */
+static int syzygy_probe_table(ChessPosition *pos, SyzygyTable *table, int dtz, SyzygyWdl wdl, SyzygyState *state)
+{
+    int squares[SYZYGY_MAX_PIECES], pieces[SYZYGY_MAX_PIECES];
+    int size = 0, lead_pawns_len = 0, file = 0, i, j, next = 0;
+    uint64_t idx;
+    Bitboard b, lead_pawns = 0;
+    SyzygyPairs *d;
+    /* the tables are stored for the named side as white, and for white to move when both sides have the same pieces */
+    int flip = (table->key == table->key2 && pos->turn_color == BLACK) || chess_position_material_key(pos) != table->key;
+    int flip_color = flip * 8, flip_squares = flip * 56;
+    int stm = flip ^ (pos->turn_color == BLACK);
+    if (table->has_pawns)
+    {
+        /* the pawns the file encodes first, their file a-d picks the table */
+        int lead = syzygy_pairs(table, dtz, 0, 0)->pieces[0] ^ flip_color;
+        lead_pawns = b = pos->pieces[lead & 8 ? BLACK : WHITE][PAWN];
+        if (!b)
+        {
+            *state = SYZYGY_FAIL;
+            return 0;
+        }
+        while (b)
+            squares[size++] = bb_pop_lsb(&b) ^ flip_squares;
+        lead_pawns_len = size;
+        for (i = 1, j = 0; i < lead_pawns_len; i++)
+            if (syzygy_pawns_before(squares[j], squares[i]))
+                j = i;
+        int tmp = squares[0];
+        squares[0] = squares[j];
+        squares[j] = tmp;
+        file = SQUARE_FILE(squares[0]);
+        if (file > 3)
+            file = 7 - file;
+    }
+    if (dtz)
+    {
+        d = syzygy_pairs(table, 1, 0, file);
+        if ((d->flags & SYZYGY_FLAG_STM) != stm && (table->key != table->key2 || table->has_pawns))
+        {
+            *state = SYZYGY_CHANGE_STM;
+            return 0;
+        }
+    }
+    b = pos->all ^ lead_pawns;
+    while (b)
+    {
+        int sq = bb_pop_lsb(&b);
+        squares[size] = sq ^ flip_squares;
+        pieces[size++] = (SYZYGY_PIECE_CODES[POS_TYPE_AT(pos, sq)] | (POS_COLOR_AT(pos, sq) == BLACK ? 8 : 0)) ^ flip_color;
+    }
+    d = syzygy_pairs(table, dtz, stm, file);
+    /* the pieces in the order the table has them */
+    for (i = lead_pawns_len; i < size - 1; i++)
+    {
+        for (j = i + 1; j < size; j++)
+        {
+            if (d->pieces[i] == pieces[j])
+            {
+                int tmp = pieces[i];
+                pieces[i] = pieces[j];
+                pieces[j] = tmp;
+                tmp = squares[i];
+                squares[i] = squares[j];
+                squares[j] = tmp;
+                break;
+            }
+        }
+    }
+    /* mirrored so the first piece is on files a-d */
+    if (SQUARE_FILE(squares[0]) > 3)
+        for (i = 0; i < size; i++)
+            squares[i] ^= 7;
+    if (table->has_pawns)
+    {
+        idx = SYZYGY_LEAD_PAWN_IDX[lead_pawns_len][squares[0]];
+        for (i = 2; i < lead_pawns_len; i++)
+            for (j = i; j > 1 && syzygy_pawns_before(squares[j], squares[j - 1]); j--)
+            {
+                int tmp = squares[j];
+                squares[j] = squares[j - 1];
+                squares[j - 1] = tmp;
+            }
+        for (i = 1; i < lead_pawns_len; i++)
+            idx += SYZYGY_BINOMIAL[i][SYZYGY_MAP_PAWNS[squares[i]]];
+    }
+    else
+    {
+        /* then onto ranks 1-4 */
+        if (SQUARE_RANK(squares[0]) > 3)
+            for (i = 0; i < size; i++)
+                squares[i] ^= 56;
+        /* and the first piece of the leading group off the a1-h8 diagonal below it */
+        for (i = 0; i < d->group_len[0]; i++)
+        {
+            if (!syzygy_off_diagonal(squares[i]))
+                continue;
+            if (syzygy_off_diagonal(squares[i]) > 0)
+                for (j = i; j < size; j++)
+                    squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+            break;
+        }
+        if (table->has_unique_pieces)
+        {
+            int adjust1 = squares[1] > squares[0];
+            int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+            if (syzygy_off_diagonal(squares[0]))
+                idx = ((uint64_t)SYZYGY_MAP_A1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+            else if (syzygy_off_diagonal(squares[1]))
+                idx = ((uint64_t)6 * 63 + SQUARE_RANK(squares[0]) * 28 + SYZYGY_MAP_B1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+            else if (syzygy_off_diagonal(squares[2]))
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + SQUARE_RANK(squares[0]) * 7 * 28 + (SQUARE_RANK(squares[1]) - adjust1) * 28 +
+                      SYZYGY_MAP_B1H1H7[squares[2]];
+            else
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + SQUARE_RANK(squares[0]) * 7 * 6 + (SQUARE_RANK(squares[1]) - adjust1) * 6 +
+                      (SQUARE_RANK(squares[2]) - adjust2);
+        }
+        else
+            idx = SYZYGY_MAP_KK[SYZYGY_MAP_A1D1D4[squares[0]]][squares[1]];
+    }
+    /* the other groups, each as the squares it takes of those the groups before left free */
+    idx *= d->group_idx[0];
+    int *group = squares + d->group_len[0];
+    int remaining_pawns = table->has_pawns && table->pawn_count[1];
+    while (d->group_len[++next])
+    {
+        uint64_t n = 0;
+        int len = d->group_len[next];
+        for (i = 1; i < len; i++)
+            for (j = i; j > 0 && group[j] < group[j - 1]; j--)
+            {
+                int tmp = group[j];
+                group[j] = group[j - 1];
+                group[j - 1] = tmp;
+            }
+        for (i = 0; i < len; i++)
+        {
+            int adjust = 0, *s;
+            for (s = squares; s < group; s++)
+                adjust += group[i] > *s;
+            n += SYZYGY_BINOMIAL[i + 1][group[i] - adjust - 8 * remaining_pawns];
+        }
+        remaining_pawns = 0;
+        idx += n * d->group_idx[next];
+        group += len;
+    }
+    int value = syzygy_decompress_pairs(d, idx);
+    if (value < 0)
+    {
+        *state = SYZYGY_FAIL;
+        return 0;
+    }
+    if (!dtz)
+        return value - 2;
+    /* the map for each result, in the order win, loss, cursed win, blessed loss */
+    static const int WDL_MAP[] = {1, 3, 0, 2, 0};
+    if (d->flags & SYZYGY_FLAG_MAPPED)
+    {
+        int at = d->map_idx[WDL_MAP[wdl + 2]] + value;
+        value = d->flags & SYZYGY_FLAG_WIDE ? syzygy_read_le16(table->dtz_map + 2 * at) : table->dtz_map[at];
+    }
+    /* some tables count moves rather than plies */
+    if ((wdl == SYZYGY_WIN && !(d->flags & SYZYGY_FLAG_WIN_PLIES)) || (wdl == SYZYGY_LOSS && !(d->flags & SYZYGY_FLAG_LOSS_PLIES)) ||
+        wdl == SYZYGY_CURSED_WIN || wdl == SYZYGY_BLESSED_LOSS)
+        value *= 2;
+    return value + 1;
+}
+
+static int syzygy_probe(ChessPosition *pos, int dtz, SyzygyWdl wdl, SyzygyState *state)
+{
+    SyzygyTable *table;
+    if (bb_popcount(pos->all) == 2)
+        return SYZYGY_DRAW;
+    table = syzygy_find(chess_position_material_key(pos));
+    if (!table || (dtz && !table->has_dtz))
+    {
+        *state = SYZYGY_FAIL;
+        return 0;
+    }
+    return syzygy_probe_table(pos, table, dtz, wdl, state);
+}
+
+/*
+    The tables don't store the result where the side to move wins by a capture, or draws by one when it would otherwise lose,
+    and know nothing of en passant. So the captures are played first, and the table is only asked when none of them is as good.
+    With zeroing, pawn moves are also played, the DTZ tables don't store positions won by a capture or pawn move.
+*/
+static SyzygyWdl syzygy_search(ChessPosition *pos, int zeroing, SyzygyState *state)
+{
+    MoveList list;
+    ChessUndo undo;
+    SyzygyWdl value, best = SYZYGY_LOSS;
+    int i, played = 0;
+    chess_position_generate_legal_moves(pos, &list);
+    for (i = 0; i < list.len; i++)
+    {
+        ChessMove m = list.moves[i];
+        if (!MOVE_IS_CAPTURE(m) && (!zeroing || POS_TYPE_AT(pos, MOVE_FROM(m)) != PAWN))
+            continue;
+        played++;
+        chess_position_make_move(pos, m, &undo);
+        value = -syzygy_search(pos, 0, state);
+        chess_position_unmake_move(pos, &undo);
+        if (*state == SYZYGY_FAIL)
+            return SYZYGY_DRAW;
+        if (value > best)
+        {
+            best = value;
+            if (value >= SYZYGY_WIN)
+            {
+                *state = SYZYGY_ZEROING_BEST_MOVE;
+                return value;
+            }
+        }
+    }
+    /* every move has been played, what the table stores could be wrong, say when the only move is en passant */
+    int no_more_moves = played && played == list.len;
+    if (no_more_moves)
+        value = best;
+    else
+    {
+        value = syzygy_probe(pos, 0, SYZYGY_DRAW, state);
+        if (*state == SYZYGY_FAIL)
+            return SYZYGY_DRAW;
+    }
+    if (best >= value)
+    {
+        *state = best > SYZYGY_DRAW || no_more_moves ? SYZYGY_ZEROING_BEST_MOVE : SYZYGY_OK;
+        return best;
+    }
+    *state = SYZYGY_OK;
+    return value;
+}
+
+static int syzygy_can_probe(ChessPosition *pos)
+{
+    return SYZYGY_LARGEST && !pos->castling && bb_popcount(pos->all) <= SYZYGY_LARGEST;
+}
+
+SyzygyWdl chess_position_probe_wdl(ChessPosition *pos, int *success)
+{
+    SyzygyState state = SYZYGY_OK;
+    SyzygyWdl wdl = SYZYGY_DRAW;
+    if (syzygy_can_probe(pos))
+        wdl = syzygy_search(pos, 0, &state);
+    else
+        state = SYZYGY_FAIL;
+    *success = state != SYZYGY_FAIL;
+    return wdl;
+}
+
+/* the DTZ of the position before a capture or pawn move that gets wdl */
+static int syzygy_dtz_before_zeroing(SyzygyWdl wdl)
+{
+    switch (wdl)
+    {
+    case SYZYGY_WIN:
+        return 1;
+    case SYZYGY_CURSED_WIN:
+        return 101;
+    case SYZYGY_BLESSED_LOSS:
+        return -101;
+    case SYZYGY_LOSS:
+        return -1;
+    default:
+        return 0;
+    }
+}
+
+static int syzygy_sign(int x)
+{
+    return (x > 0) - (x < 0);
+}
+
+static int syzygy_probe_dtz(ChessPosition *pos, SyzygyState *state)
+{
+    MoveList list;
+    ChessUndo undo;
+    int i, dtz, min_dtz = 0xFFFF;
+    *state = SYZYGY_OK;
+    SyzygyWdl wdl = syzygy_search(pos, 1, state);
+    /* draws are not stored */
+    if (*state == SYZYGY_FAIL || wdl == SYZYGY_DRAW)
+        return 0;
+    if (*state == SYZYGY_ZEROING_BEST_MOVE)
+        return syzygy_dtz_before_zeroing(wdl);
+    dtz = syzygy_probe(pos, 1, wdl, state);
+    if (*state == SYZYGY_FAIL)
+        return 0;
+    if (*state != SYZYGY_CHANGE_STM)
+        return (dtz + 100 * (wdl == SYZYGY_BLESSED_LOSS || wdl == SYZYGY_CURSED_WIN)) * syzygy_sign(wdl);
+    /* the table is for the other side to move, so each move is looked up */
+    chess_position_generate_legal_moves(pos, &list);
+    for (i = 0; i < list.len; i++)
+    {
+        ChessMove m = list.moves[i];
+        int zeroing = MOVE_IS_CAPTURE(m) || POS_TYPE_AT(pos, MOVE_FROM(m)) == PAWN;
+        chess_position_make_move(pos, m, &undo);
+        /* a zeroing move's DTZ is the one before it is played */
+        dtz = zeroing ? -syzygy_dtz_before_zeroing(syzygy_search(pos, 0, state)) : -syzygy_probe_dtz(pos, state);
+        if (dtz == 1 && chess_position_in_check(pos, pos->turn_color))
+        {
+            MoveList replies;
+            chess_position_generate_legal_moves(pos, &replies);
+            if (replies.len == 0)
+                min_dtz = 1;
+        }
+        if (!zeroing)
+            dtz += syzygy_sign(dtz);
+        if (dtz < min_dtz && syzygy_sign(dtz) == syzygy_sign(wdl))
+            min_dtz = dtz;
+        chess_position_unmake_move(pos, &undo);
+        if (*state == SYZYGY_FAIL)
+            return 0;
+    }
+    /* no moves is being mated */
+    return min_dtz == 0xFFFF ? -1 : min_dtz;
+}
+
+int chess_position_probe_dtz(ChessPosition *pos, int *success)
+{
+    SyzygyState state = SYZYGY_FAIL;
+    int dtz = 0;
+    if (syzygy_can_probe(pos))
+        dtz = syzygy_probe_dtz(pos, &state);
+    *success = state != SYZYGY_FAIL;
+    return dtz;
+}
+
+ChessMove chess_position_probe_root(ChessPosition *pos, SyzygyWdl *wdl)
+{
+    MoveList list;
+    ChessUndo undo;
+    ChessMove best_move = MOVE_NONE;
+    int i, best_rank = -4 * SYZYGY_MAX_DTZ, best_dtz = 0, fifty = pos->fifty_move_rule_turn_count;
+    if (!syzygy_can_probe(pos) || syzygy_find(chess_position_material_key(pos)) == NULL ||
+        !syzygy_find(chess_position_material_key(pos))->has_dtz)
+        return MOVE_NONE;
+    chess_position_generate_legal_moves(pos, &list);
+    for (i = 0; i < list.len; i++)
+    {
+        ChessMove m = list.moves[i];
+        SyzygyState state = SYZYGY_OK;
+        int dtz, rank;
+        chess_position_make_move(pos, m, &undo);
+        /* counted from before the move */
+        if (pos->fifty_move_rule_turn_count == 0)
+            dtz = syzygy_dtz_before_zeroing(-syzygy_search(pos, 0, &state));
+        else
+        {
+            dtz = -syzygy_probe_dtz(pos, &state);
+            dtz += syzygy_sign(dtz);
+        }
+        if (state != SYZYGY_FAIL && dtz == 2 && chess_position_in_check(pos, pos->turn_color))
+        {
+            MoveList replies;
+            chess_position_generate_legal_moves(pos, &replies);
+            if (replies.len == 0)
+                dtz = 1;
+        }
+        chess_position_unmake_move(pos, &undo);
+        if (state == SYZYGY_FAIL)
+            return MOVE_NONE;
+        /* the quickest win, then a win the fifty move rule may draw, a draw, a loss it may draw and the longest loss */
+        if (dtz > 0)
+            rank = dtz + fifty <= 99 ? 3 * SYZYGY_MAX_DTZ - dtz : 2 * SYZYGY_MAX_DTZ - dtz;
+        else if (dtz < 0)
+            rank = -dtz * 2 + fifty < 100 ? -3 * SYZYGY_MAX_DTZ - dtz : -2 * SYZYGY_MAX_DTZ - dtz;
+        else
+            rank = 0;
+        if (rank > best_rank)
+        {
+            best_rank = rank;
+            best_move = m;
+            best_dtz = dtz;
+        }
+    }
+    if (best_dtz > 0)
+        *wdl = best_dtz + fifty <= 99 ? SYZYGY_WIN : SYZYGY_CURSED_WIN;
+    else if (best_dtz < 0)
+        *wdl = -best_dtz * 2 + fifty < 100 ? SYZYGY_LOSS : SYZYGY_BLESSED_LOSS;
+    else
+        *wdl = SYZYGY_DRAW;
+    return best_move;
+}
+
+/* positions whose result is known, with the side to move winning, losing or drawing.
+    Each table is probed with both sides to move, so the side its DTZ file does not keep is searched one ply.
+    The black side of each table is probed with the colors reversed, and the pawn tables go through the pawn file encoding.
+*/
+static const struct
+{
+    const char *fen;
+    SyzygyWdl wdl;
+} SYZYGY_CHECKS[] = {
+    /* KQvK, mate in one and mated in two, then the same with black to move and the queen */
+    {"k7/8/1K6/8/8/8/8/2Q5 w - - 0 1", SYZYGY_WIN},
+    {"1k6/8/1K6/8/8/8/8/2Q5 b - - 0 1", SYZYGY_LOSS},
+    {"2q5/8/8/8/8/1k6/8/K7 b - - 0 1", SYZYGY_WIN},
+    /* KRvK, mate in one */
+    {"k7/8/1K6/8/8/8/8/2R5 w - - 0 1", SYZYGY_WIN},
+    /* KPvK, a pawn the king can't catch, for both sides to move and for black */
+    {"8/4P3/8/8/8/8/k7/4K3 w - - 0 1", SYZYGY_WIN},
+    {"8/4P3/8/8/8/8/k7/4K3 b - - 0 1", SYZYGY_LOSS},
+    {"4k3/8/8/8/8/K7/4p3/8 b - - 0 1", SYZYGY_WIN},
+    /* KPvK, a rook pawn with the other king in the corner is a draw */
+    {"k7/8/8/8/8/8/P7/1K6 w - - 0 1", SYZYGY_DRAW},
+};
+
+/* -1 if a loaded table disagrees with SYZYGY_CHECKS. The wins are all a pawn move or a mate away, so their DTZ is 1.
+    The losses are only checked for their sign, DTZ files can keep them in whole moves
+*/
+static int syzygy_check_tables(void)
+{
+    for (size_t i = 0; i < sizeof(SYZYGY_CHECKS) / sizeof(SYZYGY_CHECKS[0]); i++)
+    {
+        ChessPosition pos;
+        int success, dtz;
+        chess_position_from_fen(&pos, SYZYGY_CHECKS[i].fen);
+        SyzygyWdl wdl = chess_position_probe_wdl(&pos, &success);
+        if (!success)
+            continue;
+        if (wdl != SYZYGY_CHECKS[i].wdl)
+            return -1;
+        dtz = chess_position_probe_dtz(&pos, &success);
+        if (!success)
+            continue;
+        if (wdl == SYZYGY_WIN ? dtz != 1 : wdl == SYZYGY_LOSS ? dtz >= 0 : dtz != 0)
+            return -1;
+    }
+    return 0;
+}
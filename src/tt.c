@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/tt.h"
+
+#define TT_AGE_MASK 63
+#define TT_CACHE_LINE 64
+
+#define TT_DATA_MOVE(d) ((ChessMove)((d) & 0xFFFF))
+#define TT_DATA_SCORE(d) ((int)(int16_t)(((d) >> 16) & 0xFFFF))
+#define TT_DATA_DEPTH(d) ((int)(((d) >> 32) & 0xFF))
+#define TT_DATA_BOUND(d) ((int)(((d) >> 40) & 3))
+#define TT_DATA_AGE(d) ((unsigned)(((d) >> 42) & TT_AGE_MASK))
+
+void transposition_table_init(TranspositionTable *tt, size_t mb)
+{
+    size_t bytes = mb * 1024 * 1024, buckets = 1;
+    while (buckets * 2 * sizeof(TTBucket) <= bytes)
+        buckets *= 2;
+    /* room to start the buckets on a cache line */
+    tt->allocation = malloc(buckets * sizeof(TTBucket) + TT_CACHE_LINE);
+    if (!tt->allocation)
+    {
+        perror("Failed to allocate transposition table");
+        exit(1);
+    }
+    tt->buckets = (TTBucket *)(((uintptr_t)tt->allocation + TT_CACHE_LINE - 1) & ~(uintptr_t)(TT_CACHE_LINE - 1));
+    tt->mask = buckets - 1;
+    transposition_table_clear(tt);
+}
+
+void transposition_table_free(TranspositionTable *tt)
+{
+    free(tt->allocation);
+    memset(tt, 0, sizeof(TranspositionTable));
+}
+
+void transposition_table_clear(TranspositionTable *tt)
+{
+    memset(tt->buckets, 0, (tt->mask + 1) * sizeof(TTBucket));
+    tt->age = 0;
+}
+
+void transposition_table_new_search(TranspositionTable *tt)
+{
+    tt->age = (tt->age + 1) & TT_AGE_MASK;
+}
+
+int transposition_table_probe(TranspositionTable *tt, uint64_t key, TTData *data)
+{
+    volatile TTEntry *entries = tt->buckets[key & tt->mask].entries;
+    int i;
+    for (i = 0; i < TT_BUCKET_LEN; i++)
+    {
+        /* read once, another thread may be writing the entry */
+        uint64_t d = entries[i].data;
+        if ((entries[i].key ^ d) != key || TT_DATA_BOUND(d) == TT_BOUND_NONE)
+            continue;
+        data->move = TT_DATA_MOVE(d);
+        data->score = TT_DATA_SCORE(d);
+        data->depth = TT_DATA_DEPTH(d);
+        data->bound = TT_DATA_BOUND(d);
+        return 1;
+    }
+    return 0;
+}
+
+void transposition_table_store(TranspositionTable *tt, uint64_t key, ChessMove move, int score, int depth, int bound)
+{
+    volatile TTEntry *entries = tt->buckets[key & tt->mask].entries;
+    volatile TTEntry *replace = &entries[0];
+    int i, worst = 0x7FFFFFFF;
+    for (i = 0; i < TT_BUCKET_LEN; i++)
+    {
+        uint64_t d = entries[i].data;
+        if ((entries[i].key ^ d) == key)
+        {
+            /* keep the old best move rather than forget it */
+            if (move == MOVE_NONE)
+                move = TT_DATA_MOVE(d);
+            replace = &entries[i];
+            break;
+        }
+        /* shallow entries from older searches go first */
+        int value = TT_DATA_DEPTH(d) - 8 * (int)((tt->age - TT_DATA_AGE(d)) & TT_AGE_MASK);
+        if (value < worst)
+        {
+            worst = value;
+            replace = &entries[i];
+        }
+    }
+    if (depth < 0)
+        depth = 0;
+    uint64_t d = (uint64_t)move | ((uint64_t)(uint16_t)score << 16) | ((uint64_t)(depth & 0xFF) << 32) |
+                 ((uint64_t)bound << 40) | ((uint64_t)tt->age << 42);
+    replace->key = key ^ d;
+    replace->data = d;
+}
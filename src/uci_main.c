@@ -0,0 +1,402 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "../include/search.h"
+#include "../include/movegen.h"
+#include "../include/attacks.h"
+#include "../include/zobrist.h"
+#include "../include/fen.h"
+#include "../include/san.h"
+#include "../include/syzygy.h"
+#include "../include/book.h"
+
+#define UCI_ENGINE_NAME "c-chess"
+#define UCI_ENGINE_AUTHOR "Adam Naghs"
+#define UCI_MAX_HASH_MB 4096
+#define UCI_MAX_THREADS 256
+/* seconds kept back from each move for the GUI and the pipe */
+#define UCI_MOVE_OVERHEAD 0.05
+/* moves the remaining time is split over when the GUI does not say */
+#define UCI_DEFAULT_MOVES_TO_GO 30
+
+/* the engine state the commands change, the search runs on its own thread so stop and isready are answered */
+typedef struct
+{
+    ChessPosition pos;
+    TranspositionTable tt;
+    /* the pawn tables of the search threads */
+    PawnTables pawns;
+    int threads;
+    int tb_probe_depth;
+    /* OwnBook, the move is taken from book without searching while the position is in it */
+    int own_book;
+    PolyglotBook book;
+    /* position the search thread works on, pos can change while it runs */
+    ChessPosition search_pos;
+    SearchLimits limits;
+    /* go infinite, bestmove waits for stop even when the search ends first */
+    int infinite;
+    volatile int stop;
+    /* a search thread has been started and not joined */
+    int searching;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t stopped;
+    /* reused by each move of a position command */
+    MoveIndex index;
+} UciEngine;
+
+/* next space separated word of *line, moves *line past it. Returns NULL at the end of the line */
+static char *uci_next_word(char **line)
+{
+    char *word = *line;
+    while (*word == ' ' || *word == '\t')
+        word++;
+    if (!*word)
+        return NULL;
+    char *end = word;
+    while (*end && *end != ' ' && *end != '\t')
+        end++;
+    if (*end)
+        *end++ = 0;
+    *line = end;
+    return word;
+}
+
+/* score cp or score mate, mates are counted in moves and negative when the engine is mated */
+static int uci_write_score(char *buf, int score)
+{
+    if (score >= SEARCH_MATE_BOUND)
+        return sprintf(buf, "mate %d", (SEARCH_MATE - score + 1) / 2);
+    if (score <= -SEARCH_MATE_BOUND)
+        return sprintf(buf, "mate %d", -(SEARCH_MATE + score) / 2);
+    return sprintf(buf, "cp %d", score);
+}
+
+/* the principal variation is read back from the table, it ends at the first move that is missing or illegal */
+static void uci_print_info(const SearchResult *result, void *arg)
+{
+    UciEngine *engine = (UciEngine *)arg;
+    char buf[SEARCH_MAX_PLY * 6 + 128];
+    ChessPosition pos = engine->search_pos;
+    ChessMove move = result->best_move;
+    int len, i;
+    double time = result->time > 0 ? result->time : 1e-6;
+    len = sprintf(buf, "info depth %d score ", result->depth);
+    len += uci_write_score(buf + len, result->score);
+    len += sprintf(buf + len, " nodes %llu nps %llu tbhits %llu time %d pv", result->nodes,
+                   (unsigned long long)(result->nodes / time), result->tb_hits, (int)(result->time * 1000));
+    /* a move from the tablebases comes with depth 0 */
+    for (i = 0; (i < result->depth || i == 0) && move != MOVE_NONE; i++)
+    {
+        MoveList legal;
+        ChessUndo undo;
+        TTData data;
+        chess_position_generate_legal_moves(&pos, &legal);
+        if (move_list_find(&legal, move) < 0)
+            break;
+        buf[len++] = ' ';
+        move_to_string(move, buf + len);
+        len += strlen(buf + len);
+        chess_position_make_move(&pos, move, &undo);
+        move = transposition_table_probe(&engine->tt, pos.key, &data) ? data.move : MOVE_NONE;
+    }
+    buf[len] = 0;
+    printf("%s\n", buf);
+    fflush(stdout);
+}
+
+static void *uci_search_main(void *arg)
+{
+    UciEngine *engine = (UciEngine *)arg;
+    SearchResult result;
+    char move[6] = "0000";
+    chess_position_search(&engine->search_pos, &engine->limits, &engine->tt, &engine->pawns, &result);
+    /* the GUI must not get a bestmove for go infinite before it sends stop */
+    pthread_mutex_lock(&engine->lock);
+    while (engine->infinite && !engine->stop)
+        pthread_cond_wait(&engine->stopped, &engine->lock);
+    pthread_mutex_unlock(&engine->lock);
+    if (result.best_move != MOVE_NONE)
+        move_to_string(result.best_move, move);
+    printf("bestmove %s\n", move);
+    fflush(stdout);
+    return NULL;
+}
+
+/* ends the search if one is running and waits for its bestmove */
+static void uci_stop(UciEngine *engine)
+{
+    if (!engine->searching)
+        return;
+    pthread_mutex_lock(&engine->lock);
+    engine->stop = 1;
+    pthread_cond_signal(&engine->stopped);
+    pthread_mutex_unlock(&engine->lock);
+    pthread_join(engine->thread, NULL);
+    engine->searching = 0;
+}
+
+/* position [startpos | fen <fen>] [moves <move>...] */
+static void uci_position(UciEngine *engine, char *args)
+{
+    char *word = uci_next_word(&args);
+    ChessPosition pos;
+    if (word && strcmp(word, "startpos") == 0)
+        chess_position_from_fen(&pos, FEN_START);
+    else if (word && strcmp(word, "fen") == 0)
+    {
+        int len = chess_position_from_fen(&pos, args);
+        if (len < 0)
+        {
+            printf("info string invalid fen\n");
+            return;
+        }
+        args += len;
+    }
+    else
+    {
+        printf("info string position needs startpos or fen\n");
+        return;
+    }
+    word = uci_next_word(&args);
+    if (word && strcmp(word, "moves") == 0)
+    {
+        while ((word = uci_next_word(&args)))
+        {
+            MoveList legal;
+            SanList labels;
+            ChessUndo undo;
+            chess_position_generate_legal_moves(&pos, &legal);
+            chess_position_moves_to_san(&pos, &legal, &labels);
+            move_index_build(&engine->index, &pos, &legal, &labels);
+            int x = move_index_find(&engine->index, word);
+            if (x < 0)
+            {
+                printf("info string illegal move %s\n", word);
+                break;
+            }
+            chess_position_make_move(&pos, legal.moves[x], &undo);
+        }
+    }
+    engine->pos = pos;
+}
+
+/* go [depth <plies>] [movetime <ms>] [nodes <n>] [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>] [infinite] */
+static void uci_go(UciEngine *engine, char *args)
+{
+    SearchLimits limits = {0};
+    double time_left[2] = {0, 0}, increment[2] = {0, 0};
+    int moves_to_go = 0, limited = 0;
+    char *word;
+    engine->infinite = 0;
+    while ((word = uci_next_word(&args)))
+    {
+        char *value = strcmp(word, "infinite") == 0 ? NULL : uci_next_word(&args);
+        if (strcmp(word, "infinite") == 0)
+            engine->infinite = 1;
+        else if (!value)
+            break;
+        else if (strcmp(word, "depth") == 0)
+            limits.max_depth = atoi(value);
+        else if (strcmp(word, "movetime") == 0)
+            limits.move_time = atoi(value) / 1000.0;
+        else if (strcmp(word, "nodes") == 0)
+            limits.max_nodes = strtoull(value, NULL, 10);
+        else if (strcmp(word, "wtime") == 0)
+            time_left[WHITE] = atoi(value) / 1000.0;
+        else if (strcmp(word, "btime") == 0)
+            time_left[BLACK] = atoi(value) / 1000.0;
+        else if (strcmp(word, "winc") == 0)
+            increment[WHITE] = atoi(value) / 1000.0;
+        else if (strcmp(word, "binc") == 0)
+            increment[BLACK] = atoi(value) / 1000.0;
+        else if (strcmp(word, "movestogo") == 0)
+            moves_to_go = atoi(value);
+        limited = 1;
+    }
+    ChessColor us = engine->pos.turn_color;
+    if (time_left[us] > 0 && limits.move_time == 0)
+    {
+        /* an even share of the clock plus most of the increment, never more than is left */
+        double share = time_left[us] / (moves_to_go > 0 ? moves_to_go : UCI_DEFAULT_MOVES_TO_GO) + increment[us] * 0.75;
+        double most = time_left[us] - UCI_MOVE_OVERHEAD;
+        limits.move_time = share < most ? share : most;
+        if (limits.move_time < 0.01)
+            limits.move_time = 0.01;
+    }
+    /* a bare go searches until stop */
+    if (!limited)
+        engine->infinite = 1;
+    /* the book is not used to analyse */
+    if (engine->own_book && !engine->infinite)
+    {
+        ChessMove book_move = polyglot_book_pick(&engine->book, &engine->pos, ((uint64_t)rand() << 31) ^ (uint64_t)rand());
+        if (book_move != MOVE_NONE)
+        {
+            char move[6];
+            move_to_string(book_move, move);
+            printf("info string book move\nbestmove %s\n", move);
+            return;
+        }
+    }
+    limits.threads = engine->threads;
+    limits.tb_probe_depth = engine->tb_probe_depth;
+    limits.stop = &engine->stop;
+    limits.on_depth = uci_print_info;
+    limits.arg = engine;
+    engine->limits = limits;
+    engine->search_pos = engine->pos;
+    engine->stop = 0;
+    if (pthread_create(&engine->thread, NULL, uci_search_main, engine) != 0)
+    {
+        perror("Failed to start search thread");
+        exit(1);
+    }
+    engine->searching = 1;
+}
+
+/* setoption name <Hash | Threads | SyzygyPath | SyzygyProbeDepth | OwnBook | BookFile> value <v> */
+static void uci_set_option(UciEngine *engine, char *args)
+{
+    char *word, name[64] = "", *text = "";
+    while ((word = uci_next_word(&args)))
+    {
+        if (strcmp(word, "name") == 0 && (word = uci_next_word(&args)))
+            snprintf(name, sizeof(name), "%s", word);
+        else if (strcmp(word, "value") == 0)
+        {
+            /* the rest of the line, paths can have spaces */
+            while (*args == ' ' || *args == '\t')
+                args++;
+            text = args;
+            break;
+        }
+    }
+    int value = atoi(text);
+    if (strcmp(name, "Hash") == 0 && value >= 1 && value <= UCI_MAX_HASH_MB)
+    {
+        transposition_table_free(&engine->tt);
+        transposition_table_init(&engine->tt, value);
+    }
+    else if (strcmp(name, "Threads") == 0 && value >= 1 && value <= UCI_MAX_THREADS)
+        engine->threads = value;
+    else if (strcmp(name, "SyzygyPath") == 0)
+    {
+        int pieces = syzygy_init(strcmp(text, "<empty>") == 0 ? NULL : text);
+        if (pieces)
+            printf("info string found tablebases of up to %d pieces\n", pieces);
+        else if (*text && strcmp(text, "<empty>") != 0)
+            printf("info string no tablebases in %s\n", text);
+    }
+    else if (strcmp(name, "SyzygyProbeDepth") == 0 && value >= 0 && value < SEARCH_MAX_PLY)
+        engine->tb_probe_depth = value;
+    else if (strcmp(name, "OwnBook") == 0)
+        engine->own_book = strcmp(text, "true") == 0;
+    else if (strcmp(name, "BookFile") == 0)
+    {
+        polyglot_book_close(&engine->book);
+        if (!*text || strcmp(text, "<empty>") == 0)
+            return;
+        if (polyglot_book_open(&engine->book, text) < 0)
+            printf("info string can't use the book %s\n", text);
+        else
+            printf("info string book of %zu entries\n", engine->book.len);
+    }
+    else
+        printf("info string unknown option %s\n", name);
+}
+
+int main(void)
+{
+    UciEngine *engine = calloc(1, sizeof(UciEngine));
+    if (!engine)
+    {
+        perror("Failed to allocate engine");
+        exit(1);
+    }
+    chess_attacks_init();
+    chess_zobrist_init();
+    chess_position_from_fen(&engine->pos, FEN_START);
+    transposition_table_init(&engine->tt, TT_DEFAULT_MB);
+    pawn_tables_init(&engine->pawns);
+    engine->threads = 1;
+    move_index_init(&engine->index);
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->stopped, NULL);
+    while (1)
+    {
+        size_t len;
+        char *line = input('\n', &len), *args = line;
+        if (len == 0 && feof(stdin))
+        {
+            /* input piped from a file ends without quit, its last search is let finish */
+            if (engine->searching && !engine->infinite)
+            {
+                pthread_join(engine->thread, NULL);
+                engine->searching = 0;
+            }
+            free(line);
+            break;
+        }
+        if (len > 0 && line[len - 1] == '\r')
+            line[len - 1] = 0;
+        char *command = uci_next_word(&args);
+        int quit = 0;
+        if (!command)
+            ;
+        else if (strcmp(command, "uci") == 0)
+        {
+            printf("id name " UCI_ENGINE_NAME "\n");
+            printf("id author " UCI_ENGINE_AUTHOR "\n");
+            printf("option name Hash type spin default %d min 1 max %d\n", TT_DEFAULT_MB, UCI_MAX_HASH_MB);
+            printf("option name Threads type spin default 1 min 1 max %d\n", UCI_MAX_THREADS);
+            printf("option name SyzygyPath type string default <empty>\n");
+            printf("option name SyzygyProbeDepth type spin default 0 min 0 max %d\n", SEARCH_MAX_PLY - 1);
+            printf("option name OwnBook type check default false\n");
+            printf("option name BookFile type string default <empty>\n");
+            printf("uciok\n");
+        }
+        else if (strcmp(command, "isready") == 0)
+            printf("readyok\n");
+        else if (strcmp(command, "ucinewgame") == 0)
+        {
+            uci_stop(engine);
+            transposition_table_clear(&engine->tt);
+        }
+        else if (strcmp(command, "position") == 0)
+        {
+            uci_stop(engine);
+            uci_position(engine, args);
+        }
+        else if (strcmp(command, "go") == 0)
+        {
+            uci_stop(engine);
+            uci_go(engine, args);
+        }
+        else if (strcmp(command, "stop") == 0)
+            uci_stop(engine);
+        else if (strcmp(command, "setoption") == 0)
+        {
+            uci_stop(engine);
+            uci_set_option(engine, args);
+        }
+        else if (strcmp(command, "quit") == 0)
+            quit = 1;
+        else
+            printf("info string unknown command %s\n", command);
+        fflush(stdout);
+        free(line);
+        if (quit)
+            break;
+    }
+    uci_stop(engine);
+    syzygy_free();
+    polyglot_book_close(&engine->book);
+    transposition_table_free(&engine->tt);
+    pawn_tables_free(&engine->pawns);
+    pthread_mutex_destroy(&engine->lock);
+    pthread_cond_destroy(&engine->stopped);
+    free(engine);
+    return 0;
+}
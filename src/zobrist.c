@@ -0,0 +1,66 @@
+#include "../include/zobrist.h"
+
+uint64_t ZOBRIST_PIECES[2][KING + 1][CHESS_BOARD_LEN];
+uint64_t ZOBRIST_CASTLING[CASTLE_ALL + 1];
+uint64_t ZOBRIST_EN_PASSANT[CHESS_BOARD_WIDTH];
+uint64_t ZOBRIST_TURN;
+
+/* splitmix64, the same keys every run so hashes can be stored */
+static uint64_t zobrist_rand(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void chess_zobrist_init(void)
+{
+    static int initialized = 0;
+    uint64_t state = 0x43484553535A4F42ULL;
+    uint64_t rights[4];
+    int c, t, sq, i;
+    if (initialized)
+        return;
+    initialized = 1;
+    for (c = 0; c < 2; c++)
+        for (t = PAWN; t <= KING; t++)
+            for (sq = 0; sq < CHESS_BOARD_LEN; sq++)
+                ZOBRIST_PIECES[c][t][sq] = zobrist_rand(&state);
+    for (i = 0; i < 4; i++)
+        rights[i] = zobrist_rand(&state);
+    /* each combination of rights is the xor of its single rights */
+    for (c = 0; c <= CASTLE_ALL; c++)
+    {
+        ZOBRIST_CASTLING[c] = 0;
+        for (i = 0; i < 4; i++)
+            if (c & (1 << i))
+                ZOBRIST_CASTLING[c] ^= rights[i];
+    }
+    for (i = 0; i < CHESS_BOARD_WIDTH; i++)
+        ZOBRIST_EN_PASSANT[i] = zobrist_rand(&state);
+    ZOBRIST_TURN = zobrist_rand(&state);
+}
+
+uint64_t chess_position_compute_key(ChessPosition *pos)
+{
+    uint64_t key = ZOBRIST_CASTLING[pos->castling];
+    Bitboard pieces = pos->all;
+    while (pieces)
+    {
+        int sq = bb_pop_lsb(&pieces);
+        key ^= ZOBRIST_PIECES[POS_COLOR_AT(pos, sq)][POS_TYPE_AT(pos, sq)][sq];
+    }
+    if (pos->en_passant != NO_SQUARE)
+        key ^= ZOBRIST_EN_PASSANT[SQUARE_FILE(pos->en_passant)];
+    if (pos->turn_color == BLACK)
+        key ^= ZOBRIST_TURN;
+    return key;
+}
+
+uint64_t chess_game_hash(ChessGame *game)
+{
+    ChessPosition pos;
+    chess_position_from_game(&pos, game);
+    return pos.key;
+}